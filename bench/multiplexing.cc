@@ -0,0 +1,70 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <thread>
+#include <vector>
+
+#include "resply.h"
+
+
+namespace {
+
+/*! \brief Runs \p threads threads, each sending \p commands blocking INCRs using \p send. */
+template <typename Send>
+void run(const char* name, int threads, int commands, Send send)
+{
+        std::vector<std::thread> workers;
+        auto start{std::chrono::steady_clock::now()};
+
+        for (int i{}; i < threads; i++) {
+                workers.emplace_back([&send, commands, i]() {
+                        for (int j{}; j < commands; j++) {
+                                send(i);
+                        }
+                });
+        }
+
+        for (std::thread& worker: workers) {
+                worker.join();
+        }
+
+        std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+        std::printf("%-40s %2d threads %9.0f commands/s\n", name, threads, threads * commands / elapsed.count());
+}
+
+}
+
+
+int main()
+{
+        const int COMMANDS{20000};
+
+        for (int threads: {1, 4, 16, 64}) {
+                // One connection per thread.
+                std::vector<std::unique_ptr<resply::Client>> clients;
+                for (int i{}; i < threads; i++) {
+                        clients.push_back(std::make_unique<resply::Client>());
+                        clients.back()->connect();
+                }
+
+                run("connection per thread", threads, COMMANDS / threads * 4, [&clients](int i) {
+                        clients[i]->command("incr", "bench-multiplexed");
+                });
+
+                // One connection shared by all threads.
+                resply::MultiplexedClient multiplexed;
+                multiplexed.connect();
+
+                run("multiplexed connection", threads, COMMANDS / threads * 4, [&multiplexed](int) {
+                        multiplexed.command("incr", "bench-multiplexed");
+                });
+        }
+}
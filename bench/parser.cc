@@ -0,0 +1,174 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+
+#include "resp-parser.h"
+#include "result-builder.h"
+
+
+namespace {
+
+/*! \brief Discards all elements, so only the parser itself is measured. */
+class NullHandler : public RespHandler {
+public:
+        void on_nil() override { elements_++; }
+        void on_integer(resply::Result::Type, long long value) override { elements_++; sum_ += value; }
+        void on_double(double) override { elements_++; }
+        void on_aggregate(resply::Result::Type, std::size_t) override { }
+        void on_aggregate_end() override { }
+        void on_failure(const char*) override { }
+
+        char* on_string(resply::Result::Type, std::size_t length) override
+        {
+                elements_++;
+                scratch_.resize(std::max(scratch_.size(), length));
+
+                return scratch_.data();
+        }
+
+        std::size_t elements() const { return elements_; }
+        long long sum() const { return sum_; }
+
+private:
+        std::vector<char> scratch_;
+        std::size_t elements_{};
+        long long sum_{};
+};
+
+/*! \brief Parses all replies in \p data, each with a fresh parser like the client does. */
+template <typename Handler>
+std::size_t parse_all(const std::string& data, Handler& handler)
+{
+        const char* position{data.data()};
+        const char* const end{position + data.size()};
+        LineScanner scanner{end};
+        std::size_t replies{};
+
+        while (position != end) {
+                RespParser parser{handler};
+                position += parser.parse(position, end - position, scanner);
+                replies++;
+        }
+
+        return replies;
+}
+
+/*! \brief Parses all replies in \p data with a single parser into a pre-reserved vector, like Pipeline::send does. */
+std::vector<resply::Result> parse_batch(const std::string& data, std::size_t replies)
+{
+        const char* position{data.data()};
+        const char* const end{position + data.size()};
+        LineScanner scanner{end};
+
+        ResultBuilder builder;
+        RespParser parser{builder};
+        std::vector<resply::Result> results;
+        results.reserve(replies);
+
+        while (position != end) {
+                builder.reset(results.emplace_back());
+                parser.reset();
+                position += parser.parse(position, end - position, scanner);
+        }
+
+        return results;
+}
+
+void run_batch(const char* name, const std::string& data, std::size_t replies)
+{
+        const int ROUNDS{100};
+        double best{1e9}, best_memcpy{1e9};
+        std::vector<char> copy(data.size());
+
+        for (int round{}; round < ROUNDS; round++) {
+                auto start{std::chrono::steady_clock::now()};
+                auto results{parse_batch(data, replies)};
+                std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+
+                best = std::min(best, elapsed.count());
+
+                start = std::chrono::steady_clock::now();
+                std::memcpy(copy.data(), data.data(), data.size());
+                elapsed = std::chrono::steady_clock::now() - start;
+
+                best_memcpy = std::min(best_memcpy, elapsed.count());
+        }
+
+        std::printf("%-32s %9.1f us       (memcpy of the replies: %.1f us)\n", name, best * 1e6, best_memcpy * 1e6);
+}
+
+template <typename Handler>
+void run(const char* name, const std::string& data, std::size_t elements)
+{
+        const int ROUNDS{10};
+        double best{1e9};
+
+        for (int round{}; round < ROUNDS; round++) {
+                Handler handler;
+
+                auto start{std::chrono::steady_clock::now()};
+                parse_all(data, handler);
+                std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+
+                best = std::min(best, elapsed.count());
+        }
+
+        std::printf("%-32s %9.1f MB/s %9.1f M elements/s\n", name,
+                    data.size() / best / 1e6, elements / best / 1e6);
+}
+
+}
+
+
+int main()
+{
+        const std::size_t COUNT{1000000};
+
+        // Replies of pipelined INCRs.
+        std::string integers;
+        for (std::size_t i{}; i < COUNT; i++) {
+                integers += ':' + std::to_string(i * 7919) + "\r\n";
+        }
+
+        // Reply of a single large array of small integers, mostly headers.
+        std::string array{'*' + std::to_string(COUNT) + "\r\n"};
+        for (std::size_t i{}; i < COUNT; i++) {
+                array += ':' + std::to_string(i % 100) + "\r\n";
+        }
+
+        // Replies of pipelined LRANGEs with small bulk strings.
+        std::string bulk;
+        for (std::size_t i{}; i < COUNT / 10; i++) {
+                bulk += "*10\r\n";
+                for (int j{}; j < 10; j++) {
+                        bulk += "$8\r\nelement" + std::to_string(j) + "\r\n";
+                }
+        }
+
+        run<NullHandler>("integer replies", integers, COUNT);
+        run<NullHandler>("integer array", array, COUNT);
+        run<NullHandler>("bulk string arrays", bulk, COUNT);
+        run<ResultBuilder>("integer replies (Result)", integers, COUNT);
+        run<ResultBuilder>("integer array (Result)", array, COUNT);
+        run<ResultBuilder>("bulk string arrays (Result)", bulk, COUNT);
+
+        // Replies of a 10k-command pipeline, parsed like Pipeline::send does.
+        const std::size_t PIPELINE{10000};
+        std::string pipeline;
+        for (std::size_t i{}; i < PIPELINE; i++) {
+                pipeline += ':' + std::to_string(i) + "\r\n";
+        }
+
+        run_batch("10k pipelined integer replies", pipeline, PIPELINE);
+}
@@ -0,0 +1,66 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "resply.h"
+
+
+namespace {
+
+/*! \brief Only serializes commands, so the serializer itself is measured. */
+class NullClient : public resply::RespCommandSerializer<std::size_t> {
+private:
+        std::size_t finish_command(const resply::SerializedCommand& command) override { return command.size(); }
+};
+
+template <typename Function>
+void run(const char* name, Function function)
+{
+        const int ROUNDS{10};
+        const int COUNT{1000000};
+        double best{1e9};
+        std::size_t bytes{};
+
+        for (int round{}; round < ROUNDS; round++) {
+                NullClient client;
+                bytes = 0;
+
+                auto start{std::chrono::steady_clock::now()};
+                for (int i{}; i < COUNT; i++) {
+                        bytes += function(client, i);
+                }
+                std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+
+                best = std::min(best, elapsed.count());
+        }
+
+        std::printf("%-32s %9.1f ns/command %9.1f MB/s\n", name, best / COUNT * 1e9, bytes / best / 1e6);
+}
+
+}
+
+
+int main()
+{
+        const std::string key{"user:1234:session"};
+        const std::string value(64, 'v');
+        const std::vector<std::string> mset{"mset", key, value, key, value, key, value};
+        const resply::PreparedCommand hincrby{"hincrby", resply::placeholder, resply::placeholder, 1};
+
+        run("GET", [&](NullClient& client, int) { return client.command("get", key); });
+        run("SET", [&](NullClient& client, int) { return client.command("set", key, value); });
+        run("INCRBY", [&](NullClient& client, int i) { return client.command("incrby", key, i); });
+        run("HINCRBY", [&](NullClient& client, int) { return client.command("hincrby", key, "visits", 1); });
+        run("HINCRBY (prepared)", [&](NullClient& client, int) { return client.command(hincrby, key, "visits"); });
+        run("MSET (vector)", [&](NullClient& client, int) { return client.command(mset); });
+}
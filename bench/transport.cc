@@ -0,0 +1,64 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+#include "resply.h"
+
+
+namespace {
+
+/*! \brief Measures the round-trip latency of \p count PINGs to \p address. */
+void run(const char* name, const std::string& address, size_t count)
+{
+        resply::Client client{address};
+        client.connect();
+
+        if (!client.is_connected()) {
+                std::printf("%-28s not available\n", name);
+                return;
+        }
+
+        std::vector<double> latencies;
+        latencies.reserve(count);
+
+        for (size_t i{}; i < count; i++) {
+                auto start{std::chrono::steady_clock::now()};
+                client.command("ping");
+                std::chrono::duration<double> elapsed{std::chrono::steady_clock::now() - start};
+
+                latencies.push_back(elapsed.count());
+        }
+
+        std::sort(latencies.begin(), latencies.end());
+
+        double sum{};
+        for (double latency: latencies) {
+                sum += latency;
+        }
+
+        std::printf("%-28s mean %6.1f us  p50 %6.1f us  p99 %6.1f us\n", name, sum / count * 1e6,
+                    latencies[count / 2] * 1e6, latencies[count * 99 / 100] * 1e6);
+}
+
+}
+
+
+// Expects the redis server on localhost:6379 to also listen on /tmp/redis.sock
+// (e.g. started with `--unixsocket /tmp/redis.sock`).
+int main()
+{
+        const size_t COUNT{100000};
+
+        run("TCP loopback", "localhost:6379", COUNT);
+        run("unix domain socket", "unix:///tmp/redis.sock", COUNT);
+}
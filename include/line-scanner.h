@@ -0,0 +1,106 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+
+
+/*! \brief Finds line terminators in a chunk of received data.
+ *
+ *  The data is scanned in blocks of #BLOCK_SIZE bytes, each yielding a
+ *  bitmask of the positions of all LFs in the block. Consecutive lookups
+ *  (e.g. the lines of many small replies) are then answered from the
+ *  bitmask without touching the data again. To benefit across replies,
+ *  the scanner lives as long as the data, see ReceiveBuffer::scanner.
+ *
+ *  Blocks are scanned using AVX2 or SSE2 if the CPU supports it, which is
+ *  detected at runtime, with a scalar fallback otherwise.
+ */
+class LineScanner {
+public:
+        /*! \brief Constructs a new scanner.
+         *  \param end End of the data.
+         *
+         *  Nothing is scanned until the first call of #find.
+         */
+        explicit LineScanner(const char* end=nullptr) : block_{end}, end_{end}, mask_{} { }
+
+        /*! \brief Forgets everything scanned so far.
+         *  \param end End of the data.
+         *
+         *  Must be called whenever the data has changed.
+         */
+        void reset(const char* end) { block_ = end_ = end; mask_ = 0; }
+
+        /*! \brief Returns the end of the data.
+         *  \return Pointer one past the last byte which is scanned.
+         */
+        const char* end() const { return end_; }
+
+        /*! \brief Finds the next LF.
+         *  \param position Where to start searching, must be within the data.
+         *  \return Pointer to the LF, or nullptr if there is none before the end of the data.
+         */
+        const char* find(const char* position)
+        {
+                // Also false if position is in front of the block, as the offset wraps around.
+                const std::size_t offset(position - block_);
+
+                if (offset < BLOCK_SIZE) {
+                        // Ignore everything in front of position.
+                        std::uint64_t mask{mask_ & (~std::uint64_t{} << offset)};
+
+                        if (mask) {
+                                return block_ + count_trailing_zeros(mask);
+                        }
+                }
+
+                return find_in_next_blocks(position);
+        }
+
+        /*! \brief Returns the name of the block scanner in use, e.g. "avx2".
+         *  \return Name of the implementation.
+         */
+        static const char* implementation();
+
+private:
+        /*! \brief Number of bytes covered by a bitmask. */
+        static constexpr std::size_t BLOCK_SIZE = 64;
+
+        /*! \brief Slow path of #find, which scans new blocks as needed. */
+        const char* find_in_next_blocks(const char* position);
+
+        /*! \brief Scans the block starting at \p position into #mask_. */
+        void scan(const char* position);
+
+        /*! \brief Returns the index of the lowest set bit of \p value, which must not be zero. */
+        static unsigned count_trailing_zeros(std::uint64_t value)
+        {
+#ifdef __GNUC__
+                return __builtin_ctzll(value);
+#else
+                unsigned count{};
+                for (; !(value & 1); value >>= 1) {
+                        count++;
+                }
+
+                return count;
+#endif
+        }
+
+        /*! \brief Start of the current block. */
+        const char* block_;
+
+        /*! \brief End of the data. */
+        const char* end_;
+
+        /*! \brief Bit n is set if byte n of the current block is a LF. */
+        std::uint64_t mask_;
+};
@@ -0,0 +1,137 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#pragma once
+
+#include <cstddef>
+#include <memory>
+#include "line-scanner.h"
+
+
+/*! \brief Holds data received from a connection which has not been consumed yet.
+ *
+ *  The buffer lives as long as the connection, so bytes belonging to
+ *  following (e.g. pipelined) replies are kept for the next read.
+ *  The amount of bytes requested per read adapts to the recent traffic.
+ *
+ *  Consumed data can be pinned, see #pin, to reference it in place.
+ */
+class ReceiveBuffer {
+public:
+        ReceiveBuffer()
+                : capacity_{}, begin_{}, end_{}, read_size_{MIN_READ_SIZE},
+                  pinned_{}, pin_{}
+        { }
+
+        /*! \brief Returns the unconsumed data.
+         *  \return Pointer to the first unconsumed byte.
+         */
+        const char* data() const { return storage_.get() + begin_; }
+
+        /*! \brief Returns the amount of unconsumed data.
+         *  \return Number of unconsumed bytes.
+         */
+        std::size_t size() const { return end_ - begin_; }
+
+        /*! \brief Indicates if there is any unconsumed data.
+         *  \return If the buffer is empty.
+         */
+        bool empty() const { return begin_ == end_; }
+
+        /*! \brief Marks data as consumed.
+         *  \param count Number of bytes to consume.
+         */
+        void consume(std::size_t count);
+
+        /*! \brief Discards all unconsumed data and releases the pin. */
+        void clear() { begin_ = end_ = pin_ = 0; pinned_ = false; }
+
+        /*! \brief Keeps all data from the first unconsumed byte on in place.
+         *
+         *  Until #unpin, consumed data is neither discarded nor overwritten,
+         *  and stays contiguous at #pinned_data, even if the storage grows.
+         */
+        void pin() { pinned_ = true; pin_ = begin_; }
+
+        /*! \brief Allows pinned data to be discarded again. */
+        void unpin() { pinned_ = false; }
+
+        /*! \brief Returns the start of the pinned data.
+         *  \return Pointer to the byte which was the first unconsumed one on #pin.
+         *
+         *  This may change whenever #prepare is called.
+         */
+        const char* pinned_data() const { return storage_.get() + pin_; }
+
+        /*! \brief Makes room for the next read.
+         *  \return Pointer to at least #read_size() writable bytes.
+         */
+        char* prepare();
+
+        /*! \brief Makes data written into the region returned by #prepare available.
+         *  \param count Number of bytes which have been written.
+         *
+         *  This also adapts #read_size() for the next read.
+         */
+        void commit(std::size_t count);
+
+        /*! \brief Returns the line scanner for the received data.
+         *  \return Scanner covering the data up to the last received byte.
+         *
+         *  It is reset whenever data is received, so lines of replies
+         *  which arrived together are found in one pass.
+         */
+        LineScanner& scanner() { return scanner_; }
+
+        /*! \brief Returns how many bytes the next read should request.
+         *  \return The size of the region returned by #prepare.
+         */
+        std::size_t read_size() const { return read_size_; }
+
+        /*! \brief Returns the size of the storage.
+         *  \return Number of bytes allocated.
+         *
+         *  Grows as needed, e.g. for large replies, and is released again once
+         *  drained while far above #read_size().
+         */
+        std::size_t capacity() const { return capacity_; }
+
+private:
+        /*! \brief Smallest amount of bytes requested per read. */
+        static constexpr std::size_t MIN_READ_SIZE = 4096;
+
+        /*! \brief Largest amount of bytes requested per read. */
+        static constexpr std::size_t MAX_READ_SIZE = 1024 * 1024;
+
+        /*! \brief Storage this many times larger than #read_size_ is released when drained. */
+        static constexpr std::size_t SHRINK_FACTOR = 8;
+
+        /*! \brief The actual storage. */
+        std::unique_ptr<char[]> storage_;
+
+        /*! \brief Size of #storage_. */
+        std::size_t capacity_;
+
+        /*! \brief Offset of the first unconsumed byte. */
+        std::size_t begin_;
+
+        /*! \brief Offset one past the last received byte. */
+        std::size_t end_;
+
+        /*! \brief Amount of bytes to request for the next read. */
+        std::size_t read_size_;
+
+        /*! \brief Indicates if data is pinned. */
+        bool pinned_;
+
+        /*! \brief Offset of the pinned data, only meaningful if #pinned_. */
+        std::size_t pin_;
+
+        /*! \brief Line scanner for the data up to #end_. */
+        LineScanner scanner_;
+};
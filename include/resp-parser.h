@@ -10,32 +10,183 @@
 
 #include <cstddef>
 #include <istream>
+#include <vector>
 #include "resply.h"
+#include "line-scanner.h"
+
+
+/*! \brief Receives the elements of a reply from RespParser.
+ *
+ *  Elements are reported in the order they appear on the wire, i.e.
+ *  depth-first. Elements following #on_aggregate belong to that aggregate
+ *  until the matching #on_aggregate_end.
+ */
+class RespHandler {
+public:
+        virtual ~RespHandler() = default;
+
+        /*! \brief A nil element. */
+        virtual void on_nil() = 0;
+
+        /*! \brief An integer element.
+         *  \param type Either Type::Integer or Type::Boolean.
+         *  \param value The value of the element.
+         */
+        virtual void on_integer(resply::Result::Type type, long long value) = 0;
+
+        /*! \brief A double element.
+         *  \param value The value of the element.
+         */
+        virtual void on_double(double value) = 0;
+
+        /*! \brief A string element.
+         *  \param type Type::String, Type::ProtocolError or Type::BigNumber.
+         *  \param length Length of the string in bytes.
+         *  \return Pointer to \p length bytes where the string should be put.
+         */
+        virtual char* on_string(resply::Result::Type type, std::size_t length) = 0;
+
+        /*! \brief A string element, which is left in place instead of being copied.
+         *  \param type Type::String, Type::ProtocolError or Type::BigNumber.
+         *  \param offset Offset of the string, counted from the first byte passed to the parser.
+         *  \param length Length of the string in bytes.
+         *
+         *  Used instead of #on_string if #string_mode is StringMode::InPlace.
+         *  Only useful if all data passed to the parser is kept contiguously.
+         */
+        virtual void on_string_at(resply::Result::Type type, std::size_t offset, std::size_t length)
+        {
+                (void)type; (void)offset; (void)length;
+        }
+
+        /*! \brief (Part of) a string element, reported as soon as it arrives.
+         *  \param type Type::String, Type::ProtocolError or Type::BigNumber.
+         *  \param data The next bytes of the string, only valid during the call.
+         *  \param length Number of bytes at \p data.
+         *  \param last If this is the last part of the string.
+         *
+         *  Used instead of #on_string if #string_mode is StringMode::Chunked.
+         */
+        virtual void on_string_chunk(resply::Result::Type type, const char* data, std::size_t length, bool last)
+        {
+                (void)type; (void)data; (void)length; (void)last;
+        }
+
+        /*! \brief How string elements are reported. */
+        enum class StringMode {
+                Copy,    /*!< Copied to the memory returned by #on_string. */
+                InPlace, /*!< Reported by their position using #on_string_at. */
+                Chunked  /*!< Reported piecewise using #on_string_chunk. */
+        };
+
+        /*! \brief Indicates how string elements should be reported.
+         *  \return The mode, StringMode::Copy by default.
+         */
+        virtual StringMode string_mode() const { return StringMode::Copy; }
+
+        /*! \brief Start of an aggregate element.
+         *  \param type Type::Array, Type::Map, Type::Set or Type::Push.
+         *  \param count Number of elements, maps contain keys and values as separate elements.
+         */
+        virtual void on_aggregate(resply::Result::Type type, std::size_t count) = 0;
+
+        /*! \brief End of the innermost aggregate element. */
+        virtual void on_aggregate_end() = 0;
+
+        /*! \brief The reply is malformed, parsing has been stopped.
+         *  \param message The error message.
+         *
+         *  Anything reported so far should be replaced by a Type::ProtocolError.
+         */
+        virtual void on_failure(const char* message) = 0;
+};
 
 
 /*! \brief A streaming parser for RESP.
  *
  *  This parser is written after the specs at <https://redis.io/topics/protocol>.
+ *  Both RESP2 and RESP3 <https://github.com/antirez/RESP3/blob/master/spec.md>
+ *  are supported. Attributes are parsed, but discarded.
+ *
+ *  Arrays may be nested arbitrarily deep. Instead of recursing, the arrays
+ *  which are currently being filled are tracked on an explicit stack.
+ *
+ *  The parser itself does not build any result, but reports the elements
+ *  to a RespHandler.
  */
 class RespParser {
 public:
-        RespParser()
-                : state_{State::NeedType}, remaining_bytes_{READ_UNTIL_EOL},
-                  remaining_elements_{}
+        /*! \brief Constructs a new parser.
+         *  \param handler Handler which receives the parsed elements.
+         */
+        explicit RespParser(RespHandler& handler)
+                : handler_{handler}, discarding_{}, state_{State::NeedType}, type_{},
+                  remaining_bytes_{READ_UNTIL_EOL}, destination_{}, prefix_bytes_{},
+                  string_mode_{handler.string_mode()}, reporting_bulk_{}, offset_{}, input_{}
         { }
 
+        /*! \brief Prepares the parser for the next reply.
+         *
+         *  This keeps the allocated storage, so a single parser can parse
+         *  many consecutive (e.g. pipelined) replies cheaply.
+         */
+        void reset();
+
         /*! \brief Does the actual parsing of the data.
          *  \param stream Content to parse.
          *  \return Status if still more data is needed.
          */
         bool parse(std::istream& stream);
 
-        /*! \brief Returns the (current) result.
-         *  \return The current result.
+        /*! \brief Parses data directly from a contiguous buffer.
+         *  \param data Pointer to the first byte to parse.
+         *  \param length Number of bytes available at \p data.
+         *  \return The number of bytes consumed from \p data.
          *
-         *  Should only be called after the parsing is complete, i.e. #parse returned false.
+         *  Lines (types, sizes, simple strings and integers) are only consumed
+         *  once they are complete, an incomplete line at the end of \p data is
+         *  left untouched and must be passed in again after more data has arrived.
+         *  Bulk string payloads are consumed as they arrive.
+         *  Parsing stops at the end of the reply, so any bytes following it
+         *  (e.g. pipelined replies) are not consumed.
          */
-        const resply::Result& result() const { return result_; }
+        std::size_t parse(const char* data, std::size_t length);
+
+        /*! \brief Parses data directly from a contiguous buffer.
+         *  \param data Pointer to the first byte to parse.
+         *  \param length Number of bytes available at \p data.
+         *  \param scanner Scanner for line terminators, which must end at \p data + \p length.
+         *  \return The number of bytes consumed from \p data.
+         *
+         *  Same as #parse(const char*, std::size_t), but reuses what \p scanner
+         *  has already scanned, e.g. while parsing previous pipelined replies.
+         */
+        std::size_t parse(const char* data, std::size_t length, LineScanner& scanner);
+
+        /*! \brief Returns how many bytes of a bulk string payload are still missing.
+         *  \return Number of payload bytes which can be written to #bulk_destination.
+         *
+         *  This is zero if the parser is not in the middle of a bulk string.
+         */
+        std::size_t pending_bulk_bytes() const;
+
+        /*! \brief Returns where the rest of the current bulk string payload belongs.
+         *  \return Pointer to #pending_bulk_bytes() writable bytes.
+         *
+         *  This allows reading large payloads directly into the result,
+         *  bypassing any intermediate buffer. Call #commit_bulk afterwards.
+         */
+        char* bulk_destination() { return destination_; }
+
+        /*! \brief Marks bytes written to #bulk_destination as received.
+         *  \param count Number of bytes written.
+         */
+        void commit_bulk(std::size_t count);
+
+        /*! \brief Indicates if a complete reply has been parsed.
+         *  \return If the parser is finished.
+         */
+        bool finished() const { return state_ == State::Finished; }
 
 private:
         /*! \brief Represents the current internal parser state. */
@@ -49,33 +200,93 @@ private:
         /*! \brief The response was either a Simple String or Error - which means reading until CRLF */
         const long READ_UNTIL_EOL = -1;
 
+        /*! \brief Maximum accepted length of a bulk string, same as the default of redis. */
+        const long MAX_BULK_LENGTH = 512 * 1024 * 1024;
+
+        /*! \brief Maximum accepted number of elements (or pairs, for maps) of an aggregate. */
+        const long long MAX_AGGREGATE_SIZE = 4294967295;
+
+        /*! \brief Maximum nesting depth of arrays, bounds the size of #stack_. */
+        const std::size_t MAX_NESTING_DEPTH = 512;
+
+        /*! \brief An aggregate which is currently being filled. */
+        struct Frame {
+                /*! \brief Number of elements still missing. */
+                long long remaining;
+
+                /*! \brief Indicates if this is an attribute, which are discarded. */
+                bool attribute;
+        };
+
         /*! \brief Sets the parser state according to \p type for further parsing. */
         void parse_type(char type);
 
-        /*! \brief Sets the type of \p result accordingly to \p type. */
-        void parse_type(char type, resply::Result& result);
+        /*! \brief Starts a bulk string or pushes a new #Frame accordingly.
+         *  \param begin Start of the size line.
+         *  \param end End of the size line, excluding CRLF.
+         */
+        void parse_size(const char* begin, const char* end);
+
+        /*! \brief Consumes a complete data line and reports it.
+         *  \param begin Start of the data line.
+         *  \param end End of the data line, excluding CRLF.
+         */
+        void parse_line(const char* begin, const char* end);
+
+        /*! \brief Consumes (part of) a bulk string payload.
+         *  \param begin Start of the available data.
+         *  \param end End of the available data.
+         *  \return Number of bytes consumed.
+         */
+        std::size_t parse_bulk(const char* begin, const char* end);
+
+        /*! \brief Marks the current element as complete and advances #state_.
+         *
+         *  This also pops all aggregates which are complete now off #stack_.
+         */
+        void finish_element();
+
+        /*! \brief Returns the offset of \p position, which points into #input_. */
+        std::size_t offset_of(const char* position) const { return offset_ + (position - input_); }
 
-        /*! \brief Sets #state_ and #remaining_bytes_ (or #remaining_elements_)
-         *         accordingly for further parsing.
+        /*! \brief Reports the failure to the handler and stops parsing.
+         *  \param message The error message.
          */
-        void parse_size(const std::string& buffer);
+        void fail(const char* message);
 
-        /*! \brief Consume data and puts them into the result. */
-        void parse_data(const std::string& buffer);
+        /*! \brief Receives the parsed elements. */
+        RespHandler& handler_;
 
-        /*! \brief Holds the final (and intermediate) result. */
-        resply::Result result_;
+        /*! \brief Aggregates which are currently being filled, innermost last. */
+        std::vector<Frame> stack_;
+
+        /*! \brief Number of attributes on #stack_, nothing is reported while non-zero. */
+        std::size_t discarding_;
 
         /*! \brief Indicates the currrent parser state. */
         State state_;
 
+        /*! \brief RESP type of the element which is currently being parsed. */
+        char type_;
+
         /*! \brief Holds how many bytes must still be read to complete this element. */
         long remaining_bytes_;
 
-        /*! \brief This indicates the rememaining array elements to be read if
-         *          the response is an array.
-         */
-        long remaining_elements_;
-};
+        /*! \brief Where the rest of the current bulk string goes, nullptr if it is discarded. */
+        char* destination_;
 
+        /*! \brief Leading payload bytes which are not part of the string (verbatim string format). */
+        std::size_t prefix_bytes_;
 
+        /*! \brief How strings are reported to #handler_. */
+        const RespHandler::StringMode string_mode_;
+
+        /*! \brief Indicates if the current bulk string is still to be reported by position or in chunks. */
+        bool reporting_bulk_;
+
+        /*! \brief Number of bytes consumed by previous calls of #parse. */
+        std::size_t offset_;
+
+        /*! \brief The data passed to the current call of #parse. */
+        const char* input_;
+};
@@ -0,0 +1,131 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <tuple>
+#include <utility>
+#include <vector>
+#include <asio.hpp>
+#include "resply.h"
+
+/*! \file
+ *  \brief Asynchronous commands as asio operations, e.g. for C++20 coroutines.
+ *
+ *  Kept out of resply.h, so only users of these need asio (1.13 or newer)
+ *  in their include path. With `asio::use_awaitable` as completion token:
+ *
+ *      resply::Result value{co_await resply::async_command(client, asio::use_awaitable, "get", "key")};
+ *      std::vector<resply::Result> replies{co_await resply::async_send(pipeline, asio::use_awaitable)};
+ *
+ *  Any other completion token works as well, e.g. `asio::use_future` or a plain callback.
+ *  The client itself stays synchronous, see Client::command_async.
+ */
+
+namespace resply {
+        namespace detail {
+                /*! \brief Adapts an asio completion handler to a copyable callback.
+                 *
+                 *  The handler is invoked on its associated executor, e.g. an asio
+                 *  coroutine is resumed on its own executor instead of the one of
+                 *  the client. Until then, that executor is kept from running out of work.
+                 */
+                template <typename Handler>
+                class AsioCompletion {
+                public:
+                        explicit AsioCompletion(Handler handler)
+                                : state_{std::make_shared<State>(std::move(handler))} { }
+
+                        template <typename T>
+                        void operator()(T value) const
+                        {
+                                auto state{state_};
+                                auto executor{state->work.get_executor()};
+
+                                asio::dispatch(executor, [state, value{std::move(value)}]() mutable {
+                                        state->work.reset();
+                                        std::move(state->handler)(std::move(value));
+                                });
+                        }
+
+                private:
+                        struct State {
+                                explicit State(Handler handler)
+                                        : work{asio::make_work_guard(handler)}, handler{std::move(handler)} { }
+
+                                decltype(asio::make_work_guard(std::declval<Handler&>())) work;
+                                Handler handler;
+                        };
+
+                        std::shared_ptr<State> state_;
+                };
+        }
+
+        /*! \brief Sends a command asynchronously.
+         *  \param client A connected client, see Client::command_async for the requirements.
+         *  \param options Deadline and cancellation of the command.
+         *  \param token Completion token of signature `void(Result)`, e.g. `asio::use_awaitable`.
+         *  \param str The name of the command.
+         *  \param args A series of command arguments.
+         */
+        template <typename CompletionToken, typename... ArgTypes>
+        auto async_command(Client& client, const AsyncOptions& options, CompletionToken&& token,
+                           const std::string& str, ArgTypes&&... args)
+        {
+                // Lazy tokens like asio::use_awaitable initiate the operation after
+                // this returns, so everything is kept by value until then.
+                auto initiation{[&client, options, str, arguments{std::make_tuple(std::forward<ArgTypes>(args)...)}](
+                        auto handler
+                ) {
+                        std::apply([&](const auto&... arguments) {
+                                client.command_async([completion{detail::AsioCompletion{std::move(handler)}}](
+                                        const Result& reply
+                                ) {
+                                        completion(reply);
+                                }, options, str, arguments...);
+                        }, arguments);
+                }};
+
+                return asio::async_initiate<CompletionToken, void(Result)>(std::move(initiation), token);
+        }
+
+        /*! \brief Sends a command asynchronously.
+         *  \param client A connected client, see Client::command_async for the requirements.
+         *  \param token Completion token of signature `void(Result)`, e.g. `asio::use_awaitable`.
+         *  \param str The name of the command.
+         *  \param args A series of command arguments.
+         */
+        template <typename CompletionToken, typename... ArgTypes>
+        auto async_command(Client& client, CompletionToken&& token, const std::string& str, ArgTypes&&... args)
+        {
+                return async_command(client, AsyncOptions{}, std::forward<CompletionToken>(token),
+                                     str, std::forward<ArgTypes>(args)...);
+        }
+
+        /*! \brief Sends the batch of commands of \p pipeline asynchronously.
+         *  \param pipeline The batch of commands, see Client::Pipeline::send_async. It is
+         *                  sent when the operation is initiated, e.g. by `co_await`.
+         *  \param token Completion token of signature `void(std::vector<Result>)`.
+         *  \param options Deadline and cancellation of the whole batch.
+         */
+        template <typename CompletionToken>
+        auto async_send(Client::Pipeline& pipeline, CompletionToken&& token, const AsyncOptions& options={})
+        {
+                auto initiation{[&pipeline, options](auto handler) {
+                        pipeline.send_async([completion{detail::AsioCompletion{std::move(handler)}}](
+                                std::vector<Result> replies
+                        ) {
+                                completion(std::move(replies));
+                        }, options);
+                }};
+
+                return asio::async_initiate<CompletionToken, void(std::vector<Result>)>(std::move(initiation), token);
+        }
+}
@@ -8,27 +8,58 @@
 
 #pragma once
 
+#include <cassert>
 #include <memory>
 #include <string>
+#include <string_view>
 #include <vector>
+#include <array>
+#include <optional>
+#include <tuple>
+#include <utility>
+#include <algorithm>
+#include <charconv>
+#include <limits>
+#include <cctype>
+#include <cstdlib>
 #include <cstddef>
-#include <sstream>
+#include <ostream>
 #include <type_traits>
 #include <functional>
 #include <initializer_list>
 #include <random>
+#include <chrono>
+#include <future>
 
 
+namespace asio {
+        class io_context;
+}
+
+class ResultBuilder;
+
 namespace resply {
+        struct Result;
+
         /*! \brief Function signature for channel callbacks. */
         typedef std::function<void(const std::string& channel, const std::string& message)> ChannelCallback;
 
+        /*! \brief Function signature for out-of-band push callbacks. */
+        typedef std::function<void(const Result& push)> PushCallback;
+
+        /*! \brief Function signature for replies of streamed or asynchronous commands. */
+        typedef std::function<void(const Result& reply)> ReplyCallback;
+
 
         /*! \return The version of the resply library. */
         const std::string& version();
 
 
-        /*! \brief Holds the response of a redis command. */
+        /*! \brief Holds the response of a redis command.
+         *
+         *  The value members share their storage, which one is valid depends
+         *  on #type. This keeps large replies (e.g. MGET of many keys) compact.
+         */
         struct Result {
                 /*! \brief Indicates the type of the response. */
                 enum class Type {
@@ -37,172 +68,1685 @@ namespace resply {
                         Array,
                         ProtocolError,
                         IOError,
-                        Nil
+                        Timeout,
+                        Nil,
+
+                        // Only sent by the server if RESP3 was negotiated.
+                        Map,
+                        Set,
+                        Double,
+                        Boolean,
+                        BigNumber,
+                        Push
+                };
+
+                /*! \brief The type of a result, which decides which of its values is held.
+                 *
+                 *  Converts to Type, so it is used like a plain member, e.g. `result.type == Type::Nil`.
+                 *  `result.type()` gets the Type as well.
+                 */
+                class TypeField {
+                public:
+                        /*! \return The type of the result. */
+                        Type operator()() const { return type_; }
+
+                        /*! \return The type of the result. */
+                        operator Type() const { return type_; }
+
+                        TypeField(const TypeField&) = delete;
+                        TypeField& operator=(const TypeField&) = delete;
+
+                private:
+                        friend struct Result;
+
+                        explicit TypeField(Type type) : type_{type} { }
+
+                        /*! \brief Shared with the type of all value fields, see Result::Field. */
+                        Type type_;
+                };
+
+                /*! \brief A value of a result, which is only valid for some types of results.
+                 *  \tparam T std::string, long long, double or std::vector<Result>.
+                 *
+                 *  Converts to `const T&` and forwards the most common operations, so it
+                 *  is used like a plain member, e.g. `result.string == "OK"` or `result.array[0]`.
+                 *  `result.string()` gets the value as well.
+                 *
+                 *  Accessing the value of a result which does not hold it, e.g. #string of
+                 *  a Type::Integer result, is a bug and caught by an assertion.
+                 *
+                 *  All fields share their storage with the type in front, so it is
+                 *  known which one holds the value, see Result::holds.
+                 */
+                template <typename T>
+                class Field {
+                public:
+                        /*! \return The value, which must be held by the result. */
+                        const T& operator()() const
+                        {
+                                assert(holds(type_, static_cast<const T*>(nullptr)) && "Result does not hold this value");
+                                return value_;
+                        }
+
+                        /*! \return The value, which must be held by the result. */
+                        operator const T&() const { return (*this)(); }
+
+                        decltype(auto) operator[](size_t index) const { return (*this)()[index]; }
+                        decltype(auto) begin() const { return (*this)().begin(); }
+                        decltype(auto) end() const { return (*this)().end(); }
+                        decltype(auto) front() const { return (*this)().front(); }
+                        decltype(auto) back() const { return (*this)().back(); }
+                        decltype(auto) data() const { return (*this)().data(); }
+                        decltype(auto) c_str() const { return (*this)().c_str(); }
+                        decltype(auto) size() const { return (*this)().size(); }
+                        decltype(auto) length() const { return (*this)().length(); }
+                        decltype(auto) empty() const { return (*this)().empty(); }
+
+                        friend bool operator==(const Field& lhs, const Field& rhs) { return lhs() == rhs(); }
+                        friend bool operator!=(const Field& lhs, const Field& rhs) { return lhs() != rhs(); }
+
+                        template <typename U>
+                        friend bool operator==(const Field& lhs, const U& rhs) { return lhs() == rhs; }
+
+                        template <typename U>
+                        friend bool operator==(const U& lhs, const Field& rhs) { return lhs == rhs(); }
+
+                        template <typename U>
+                        friend bool operator!=(const Field& lhs, const U& rhs) { return lhs() != rhs; }
+
+                        template <typename U>
+                        friend bool operator!=(const U& lhs, const Field& rhs) { return lhs != rhs(); }
+
+                        friend std::ostream& operator<<(std::ostream& ostream, const Field& field)
+                        {
+                                return ostream << field();
+                        }
+
+                        Field(const Field&) = delete;
+                        Field& operator=(const Field&) = delete;
+
+                private:
+                        friend struct Result;
+                        friend struct ResultView;
+                        friend class ::ResultBuilder;
+
+                        Field(Type type, T value) : type_{type}, value_{std::move(value)} { }
+
+                        Type type_;
+                        T value_;
                 };
 
                 /*! \brief Constructs a new (empty) nil-result. */
-                Result() : type{Type::Nil} { }
+                Result() : integer{Type::Nil, 0} { }
 
                 /*! \brief Constructs  a new integer-result.
                  *  \param integer The value of the result.
                  */
-                Result(long long integer) : type{Type::Integer}, integer{integer} { }
+                Result(long long integer) : integer{Type::Integer, integer} { }
+
+                /*! \brief Constructs a new string-result.
+                 *  \param type Type::String, Type::ProtocolError, Type::IOError, Type::Timeout or Type::BigNumber.
+                 *  \param string The value of the result.
+                 */
+                Result(Type type, std::string string);
+
+                /*! \brief Constructs a new aggregate-result.
+                 *  \param type Type::Array, Type::Set, Type::Push or Type::Map.
+                 *  \param array The elements of the result.
+                 */
+                Result(Type type, std::vector<Result> array);
+
+                Result(const Result& other);
+                Result(Result&& other) noexcept;
+                Result& operator=(const Result& other);
+                Result& operator=(Result&& other) noexcept;
+                ~Result();
+
+                /*! \brief Changes the type of the result, discarding its value.
+                 *  \param type The new type.
+                 *
+                 *  The value belonging to \p type is then empty or zero.
+                 */
+                void reset(Type type);
+
+                /*! \return If #string holds the value. */
+                bool is_string() const;
+
+                /*! \return If #array holds the value. */
+                bool is_aggregate() const;
+
+                union {
+                        /*! \brief Holds the type of the response, only one of the following members is valid. */
+                        TypeField type;
 
-                /*! \brief Holds the type of the response. */
-                Type type;
+                        /*! \brief Use when #type is Type::String, Type::ProtocolError, Type::IOError, Type::Timeout or Type::BigNumber */
+                        Field<std::string> string;
 
-                /*! \brief Use when #type is Type::String, Type::ProtocolError or Type::IOError */
-                std::string string;
+                        /*! \brief Use when #type is Type::Integer or Type::Boolean */
+                        Field<long long> integer;
 
-                /*! \brief Use when #type is Type::Integer */
-                long long integer;
+                        /*! \brief Use when #type is Type::Double */
+                        Field<double> floating;
 
-                /*! \brief Use when #type is Type::Array */
-                std::vector<Result> array;
+                        /*! \brief Use when #type is Type::Array, Type::Set, Type::Push or Type::Map
+                         *
+                         *  Maps are stored as flat sequence of alternating keys and values.
+                         */
+                        Field<std::vector<Result>> array;
+                };
 
                 /*! \brief This outputs the stringify'd version of the response into the supplied stream.
                  *  \return Reference to the stream.
                  *
-                 *  It acts according to the #type field.
-                 *  If #type is either Type::ProtocolError or Type::IOError, "(error) " is
+                 *  It acts according to the #type.
+                 *  If #type is Type::ProtocolError, Type::IOError or Type::Timeout, "(error) " is
                  *  prepended to the error message. If #type is Type::Nil, the output is "(nil)".
+                 *  Maps are printed as "key => value" pairs.
                  */
                 friend std::ostream& operator<<(std::ostream& ostream, const Result& result);
+
+        private:
+                /*! \return If a result of type \p type holds a value of the given type. */
+                static bool holds(Type type, const std::string*);
+                static bool holds(Type type, const long long*);
+                static bool holds(Type type, const double*);
+                static bool holds(Type type, const std::vector<Result>*);
+
+                /*! \brief Constructs the field belonging to \p type, holding an empty or zero value. */
+                void construct(Type type);
+
+                /*! \brief Destroys the field belonging to #type. */
+                void destroy();
+
+                /*! \brief Constructs the field belonging to the type of \p other from its value. */
+                void copy_from(const Result& other);
+
+                /*! \brief Constructs the field belonging to the type of \p other from its value. */
+                void move_from(Result&& other);
         };
 
 
-        /*! \brief Implements a template-based RESP command serializer.
-         *  \param R Return type for #command.
+        /*! \brief Allocates the memory of ResultView trees.
+         *
+         *  Memory is handed out from large chunks, so even replies with many
+         *  elements only cost a few allocations. All memory is released at once,
+         *  either by #reset or when the arena is destroyed. This invalidates any
+         *  ResultView allocated from the arena.
          */
-        template <typename R>
-        class RespCommandSerializer {
+        class ResultArena {
         public:
-                /*! \brief Serializes a command and its parameters.
-                 *  \param str List of command name and its parameters.
-                 *  \return \p R
+                /*! \brief Constructs a new arena.
+                 *  \param chunk_size Size of the chunks memory is allocated in.
+                 */
+                explicit ResultArena(size_t chunk_size=64*1024);
+
+                ResultArena(const ResultArena&) = delete;
+                ResultArena& operator=(const ResultArena&) = delete;
+
+                /*! \brief Allocates memory from the arena.
+                 *  \param size Number of bytes to allocate.
+                 *  \param alignment Required alignment of the memory.
+                 *  \return Pointer to the allocated memory.
+                 */
+                void* allocate(size_t size, size_t alignment);
+
+                /*! \brief Releases all memory allocated from the arena. */
+                void reset();
+
+        private:
+                /*! \brief Chunks of #chunk_size_, the last one is the current one. */
+                std::vector<std::unique_ptr<char[]>> chunks_;
+
+                /*! \brief Dedicated chunks for allocations which do not fit into a chunk. */
+                std::vector<std::unique_ptr<char[]>> large_chunks_;
+
+                /*! \brief Next free byte in the current chunk. */
+                char* position_;
+
+                /*! \brief End of the current chunk. */
+                char* end_;
+
+                /*! \brief Size of the chunks memory is allocated in. */
+                const size_t chunk_size_;
+        };
+
+
+        /*! \brief Holds the response of a redis command, without owning any memory.
+         *
+         *  This is the compact, read-only counterpart of Result. Its strings and
+         *  elements are either allocated from a ResultArena, which must outlive
+         *  it, or reference the receive buffer of a Client (see Client::view).
+         */
+        struct ResultView {
+                /*! \brief A contiguous sequence of elements. */
+                class Array {
+                public:
+                        /*! \brief Constructs a new sequence.
+                         *  \param data The first element.
+                         *  \param size Number of elements.
+                         */
+                        Array(const ResultView* data, size_t size) : data_{data}, size_{size} { }
+
+                        /*! \return The first element. */
+                        const ResultView* begin() const { return data_; }
+
+                        /*! \return One past the last element. */
+                        const ResultView* end() const { return data_ + size_; }
+
+                        /*! \return The number of elements. */
+                        size_t size() const { return size_; }
+
+                        /*! \return If there are no elements. */
+                        bool empty() const { return !size_; }
+
+                        /*! \return The element at \p index. */
+                        const ResultView& operator[](size_t index) const { return data_[index]; }
+
+                private:
+                        const ResultView* data_;
+                        size_t size_;
+                };
+
+                /*! \brief Constructs a new (empty) nil-result. */
+                ResultView() : type{Result::Type::Nil}, integer{} { }
+
+                /*! \brief Holds the type of the response, only one of the following members is valid. */
+                Result::Type type;
+
+                union {
+                        /*! \brief Use when #type is Type::String, Type::ProtocolError, Type::IOError, Type::Timeout or Type::BigNumber */
+                        std::string_view string;
+
+                        /*! \brief Use when #type is Type::Integer or Type::Boolean */
+                        long long integer;
+
+                        /*! \brief Use when #type is Type::Double */
+                        double floating;
+
+                        /*! \brief Use when #type is Type::Array, Type::Set, Type::Push or Type::Map */
+                        Array array;
+                };
+
+                /*! \brief Copies the view into a Result, which owns its memory.
+                 *  \return The owned result.
+                 */
+                Result to_owned() const;
+        };
+
+
+        /*! \brief Receives the elements of a reply as they arrive, see Client::command_stream.
+         *
+         *  Elements are reported depth-first, in the order they appear in the
+         *  reply. Elements following #begin_array belong to that aggregate until
+         *  the matching #end_array. All methods do nothing by default.
+         */
+        class StreamHandler {
+        public:
+                virtual ~StreamHandler() = default;
+
+                /*! \brief Start of an aggregate of type Type::Array, Type::Map, Type::Set
+                 *         or Type::Push with the given number of elements.
                  *
-                 *  The command and parameters are automatically converted to RESP
-                 *  as specificed at <https://redis.io/topics/protocol>.
+                 *  Maps contain keys and values as separate elements.
                  */
-                R command(const std::vector<std::string>& str)
+                virtual void begin_array(Result::Type, size_t) { }
+
+                /*! \brief End of the innermost aggregate. */
+                virtual void end_array() { }
+
+                /*! \brief The next chunk of a string of type Type::String, Type::BigNumber,
+                 *         Type::ProtocolError, Type::IOError or Type::Timeout, and if it is the last one.
+                 *
+                 *  Large strings are reported in multiple chunks as they arrive,
+                 *  each chunk is only valid during the call.
+                 *  If the reply cannot be received (in time) or parsed, a Type::IOError,
+                 *  Type::Timeout or Type::ProtocolError is reported and nothing else follows.
+                 */
+                virtual void string_chunk(Result::Type, std::string_view, bool) { }
+
+                /*! \brief An element of type Type::Integer or Type::Boolean and its value. */
+                virtual void integer(Result::Type, long long) { }
+
+                /*! \brief An element of type Type::Double and its value. */
+                virtual void floating(double) { }
+
+                /*! \brief A nil element. */
+                virtual void nil() { }
+        };
+
+
+        /*! \brief Outcome of decoding a reply into a C++ type, see Client::command_as. */
+        enum class DecodeStatus {
+                Ok,            /*!< The reply has been decoded successfully. */
+                TypeMismatch,  /*!< The reply does not fit into the requested type. */
+                ProtocolError, /*!< The server replied with an error or the reply is malformed. */
+                IOError,       /*!< The reply could not be received. */
+                Timeout        /*!< The reply did not arrive in time. */
+        };
+
+        /*! \brief Holds a reply decoded into a value of type \p T. */
+        template <typename T>
+        struct TypedResult {
+                /*! \brief Indicates if decoding was successful. */
+                DecodeStatus status = DecodeStatus::Ok;
+
+                /*! \brief The decoded value, default-constructed if decoding failed. */
+                T value{};
+
+                /*! \brief Describes the error, if decoding failed. */
+                std::string error;
+
+                /*! \brief Checks if decoding was successful. */
+                explicit operator bool() const { return status == DecodeStatus::Ok; }
+        };
+
+
+        namespace detail {
+                /*! \brief Parses a number in the notation of RESP3 doubles, e.g. "1.5", "+3e10" or "-inf".
+                 *  \param digits The whole number.
+                 *  \param value Receives the number.
+                 *  \return If all of \p digits is such a number.
+                 *
+                 *  Unlike std::strtod, this does not depend on the locale.
+                 */
+                template <typename T>
+                bool parse_floating(std::string_view digits, T& value)
                 {
-                        std::stringstream builder;
+                        // std::from_chars does not accept an explicit plus sign.
+                        if (digits.size() > 1 && digits[0] == '+' && digits[1] != '+' && digits[1] != '-') {
+                                digits.remove_prefix(1);
+                        }
 
-                        if (str.empty()) {
-                                return command(builder);
+                        const char* end{digits.data() + digits.size()};
+                        auto [position, error] = std::from_chars(digits.data(), end, value);
+
+                        return error == std::errc{} && position == end;
+                }
+        }
+
+
+        /*! \brief Decodes the elements of a reply into a value of some type.
+         *
+         *  TypedSink specializations implement this for the supported types.
+         *  The methods return false (or nullptr) if the element does not fit.
+         */
+        class TypedSinkBase {
+        public:
+                virtual ~TypedSinkBase() = default;
+
+                /*! \brief Describes the decoded type for error messages, e.g. "an integer". */
+                virtual std::string name() const = 0;
+
+                /*! \brief An element of type Type::Integer or Type::Boolean. */
+                virtual bool integer(Result::Type, long long) { return false; }
+
+                /*! \brief An element of type Type::Double. */
+                virtual bool floating(double) { return false; }
+
+                /*! \brief The next chunk of a Type::String or Type::BigNumber. */
+                virtual bool string_chunk(Result::Type, std::string_view, bool /* first */, bool /* last */) { return false; }
+
+                /*! \brief A nil element. */
+                virtual bool nil() { return false; }
+
+                /*! \brief Start of an aggregate with the given number of elements.
+                 *  \return The sink receiving its elements, nullptr if it does not fit.
+                 */
+                virtual TypedSinkBase* begin_array(Result::Type, size_t) { return nullptr; }
+
+                /*! \brief Prepares the next element of an aggregate.
+                 *  \return The sink for the element.
+                 */
+                virtual TypedSinkBase& element() { return *this; }
+
+                /*! \brief The element prepared by #element is complete. */
+                virtual void element_done() { }
+        };
+
+        /*! \brief Decodes elements into a value of type \p T.
+         *
+         *  Specialized for integers, bool, floating point numbers, std::string,
+         *  std::optional, std::vector, maps, std::pair and std::tuple. Each
+         *  specialization provides `void bind(T& target)`, which sets the value
+         *  the next element is decoded into.
+         */
+        template <typename T, typename = void>
+        class TypedSink;
+
+        /*! \brief Decodes integer elements, as well as strings consisting of a number. */
+        template <typename T>
+        class TypedSink<T, std::enable_if_t<std::is_integral<T>::value && !std::is_same<T, bool>::value>>
+                : public TypedSinkBase {
+        public:
+                void bind(T& target) { target_ = &target; }
+
+                std::string name() const override
+                {
+                        return "an integer between " + std::to_string(+std::numeric_limits<T>::min()) +
+                               " and " + std::to_string(+std::numeric_limits<T>::max());
+                }
+
+                bool integer(Result::Type, long long value) override
+                {
+                        const T narrowed{static_cast<T>(value)};
+
+                        if ((value < 0 && std::is_unsigned<T>::value) || static_cast<long long>(narrowed) != value) {
+                                return false;
                         }
 
-                        builder << '*' << str.size() << "\r\n";
+                        *target_ = narrowed;
+                        return true;
+                }
 
-                        for (const std::string& part: str) {
-                                builder << '$' << part.length() << "\r\n" << part << "\r\n";
+                bool string_chunk(Result::Type, std::string_view chunk, bool first, bool last) override
+                {
+                        if (first && last) {
+                                return decode(chunk);
                         }
 
-                        return command(builder);
+                        if (first) {
+                                digits_.clear();
+                        }
+
+                        digits_.append(chunk);
+                        return !last || decode(digits_);
                 }
 
-                /*! \brief Serializes a command and its parameters.
-                 *  \param str The name of the command.
-                 *  \param args A series of command arguments.
-                 *  \return \p R
-                 *
-                 *  The command and parameters are automatically converted to RESP
-                 *  as specificed at <https://redis.io/topics/protocol>.
-                 */
-                template <typename... ArgTypes>
-                R command(const std::string& str, ArgTypes... args)
+        private:
+                bool decode(std::string_view digits)
                 {
-                        std::stringstream builder;
+                        const char* end{digits.data() + digits.size()};
+                        auto [position, error] = std::from_chars(digits.data(), end, *target_);
 
-                        if (str.empty()) {
-                                return command(builder);
+                        return error == std::errc{} && position == end;
+                }
+
+                T* target_{};
+                std::string digits_;
+        };
+
+        /*! \brief Decodes boolean and integer elements. */
+        template <>
+        class TypedSink<bool> : public TypedSinkBase {
+        public:
+                void bind(bool& target) { target_ = &target; }
+
+                std::string name() const override { return "a boolean"; }
+
+                bool integer(Result::Type, long long value) override
+                {
+                        *target_ = value != 0;
+                        return true;
+                }
+
+        private:
+                bool* target_{};
+        };
+
+        /*! \brief Decodes double and integer elements, as well as strings consisting of a number. */
+        template <typename T>
+        class TypedSink<T, std::enable_if_t<std::is_floating_point<T>::value>> : public TypedSinkBase {
+        public:
+                void bind(T& target) { target_ = &target; }
+
+                std::string name() const override { return "a floating point number"; }
+
+                bool integer(Result::Type type, long long value) override
+                {
+                        *target_ = static_cast<T>(value);
+                        return type == Result::Type::Integer;
+                }
+
+                bool floating(double value) override
+                {
+                        *target_ = static_cast<T>(value);
+                        return true;
+                }
+
+                bool string_chunk(Result::Type, std::string_view chunk, bool first, bool last) override
+                {
+                        if (first) {
+                                digits_.clear();
                         }
 
-                        builder << '*' << sizeof...(ArgTypes) + 1 << "\r\n";
-                        return command(builder, str, args...);
+                        digits_.append(chunk);
+
+                        if (!last) {
+                                return true;
+                        }
+
+                        // Same format as RESP3 doubles, e.g. "1.5", "-inf" or "3e10".
+                        return detail::parse_floating(digits_, *target_);
                 }
 
         private:
-                /*! \brief String-specialization variant of #command. */
-                template <typename... ArgTypes>
-                R command(std::stringstream& builder, const std::string& str, ArgTypes... args)
+                T* target_{};
+                std::string digits_;
+        };
+
+        /*! \brief Decodes string elements. */
+        template <>
+        class TypedSink<std::string> : public TypedSinkBase {
+        public:
+                void bind(std::string& target) { target_ = &target; }
+
+                std::string name() const override { return "a string"; }
+
+                bool string_chunk(Result::Type, std::string_view chunk, bool first, bool) override
+                {
+                        if (first) {
+                                target_->assign(chunk);
+                        } else {
+                                target_->append(chunk);
+                        }
+
+                        return true;
+                }
+
+        private:
+                std::string* target_{};
+        };
+
+        /*! \brief Decodes nil elements into std::nullopt, anything else like \p T. */
+        template <typename T>
+        class TypedSink<std::optional<T>> : public TypedSinkBase {
+        public:
+                void bind(std::optional<T>& target) { target_ = &target; }
+
+                std::string name() const override { return value_.name(); }
+
+                bool integer(Result::Type type, long long value) override
                 {
-                        builder << '$' << str.length() << "\r\n" << str << "\r\n";
-                        return command(builder, args...);
+                        return prepare().integer(type, value);
                 }
 
-                /*! \brief Number-specialization variant of #command. */
-                template <typename T,
-                          typename = typename std::enable_if<std::is_integral<T>::value, T>::type,
-                          typename... ArgTypes>
-                R command(std::stringstream& builder, T num, ArgTypes... args)
-                {
-                        return command(builder, std::to_string(num), args...);
-                }
+                bool floating(double value) override
+                {
+                        return prepare().floating(value);
+                }
+
+                bool string_chunk(Result::Type type, std::string_view chunk, bool first, bool last) override
+                {
+                        return (first ? prepare() : value_).string_chunk(type, chunk, first, last);
+                }
+
+                bool nil() override
+                {
+                        target_->reset();
+                        return true;
+                }
+
+                TypedSinkBase* begin_array(Result::Type type, size_t count) override
+                {
+                        return prepare().begin_array(type, count);
+                }
+
+        private:
+                /*! \brief Puts a value into the optional for decoding the element. */
+                TypedSink<T>& prepare()
+                {
+                        value_.bind(target_->emplace());
+                        return value_;
+                }
+
+                std::optional<T>* target_{};
+                TypedSink<T> value_;
+        };
+
+        /*! \brief Decodes aggregates of any size into a vector. */
+        template <typename T, typename Allocator>
+        class TypedSink<std::vector<T, Allocator>> : public TypedSinkBase {
+        public:
+                void bind(std::vector<T, Allocator>& target) { target_ = &target; }
+
+                std::string name() const override { return "an array"; }
+
+                TypedSinkBase* begin_array(Result::Type, size_t count) override
+                {
+                        target_->clear();
+                        // The size is announced by the server, so do not trust it blindly.
+                        target_->reserve(std::min<size_t>(count, 64 * 1024));
+
+                        return this;
+                }
+
+                TypedSinkBase& element() override
+                {
+                        element_.bind(target_->emplace_back());
+                        return element_;
+                }
+
+        private:
+                std::vector<T, Allocator>* target_{};
+                TypedSink<T> element_;
+        };
+
+        /*! \brief Decodes maps, as well as aggregates of alternating keys and values
+         *         (e.g. HGETALL with RESP2), into std::map, std::unordered_map and alike.
+         */
+        template <typename T>
+        class TypedSink<T, std::void_t<typename T::key_type, typename T::mapped_type>> : public TypedSinkBase {
+        public:
+                void bind(T& target) { target_ = &target; }
+
+                std::string name() const override { return "a map"; }
+
+                TypedSinkBase* begin_array(Result::Type, size_t count) override
+                {
+                        if (count % 2) {
+                                return nullptr;
+                        }
+
+                        target_->clear();
+                        is_key_ = true;
+
+                        return this;
+                }
+
+                TypedSinkBase& element() override
+                {
+                        if (is_key_) {
+                                key_sink_.bind(key_);
+                                return key_sink_;
+                        }
+
+                        value_sink_.bind(value_);
+                        return value_sink_;
+                }
+
+                void element_done() override
+                {
+                        if (!is_key_) {
+                                target_->emplace(std::move(key_), std::move(value_));
+                        }
+
+                        is_key_ = !is_key_;
+                }
+
+        private:
+                using Key = std::remove_const_t<typename T::key_type>;
+                using Value = typename T::mapped_type;
+
+                T* target_{};
+                bool is_key_{};
+
+                Key key_{};
+                Value value_{};
+                TypedSink<Key> key_sink_;
+                TypedSink<Value> value_sink_;
+        };
+
+        /*! \brief Decodes aggregates of exactly as many elements as \p T has into \p T.
+         *  \param T Either std::pair or std::tuple of \p Ts.
+         */
+        template <typename T, typename... Ts>
+        class TupleSink : public TypedSinkBase {
+        public:
+                TupleSink() : TupleSink{std::index_sequence_for<Ts...>{}} { }
+
+                TupleSink(const TupleSink&) = delete;
+                TupleSink& operator=(const TupleSink&) = delete;
+
+                void bind(T& target) { bind(target, std::index_sequence_for<Ts...>{}); }
+
+                std::string name() const override
+                {
+                        return "an array of " + std::to_string(sizeof...(Ts)) + " elements";
+                }
+
+                TypedSinkBase* begin_array(Result::Type, size_t count) override
+                {
+                        next_ = 0;
+                        return count == sizeof...(Ts) ? this : nullptr;
+                }
+
+                TypedSinkBase& element() override { return *sinks_[next_++]; }
+
+        private:
+                template <size_t... I>
+                explicit TupleSink(std::index_sequence<I...>) : sinks_{{&std::get<I>(elements_)...}} { }
+
+                template <size_t... I>
+                void bind(T& target, std::index_sequence<I...>)
+                {
+                        (std::get<I>(elements_).bind(std::get<I>(target)), ...);
+                }
+
+                std::tuple<TypedSink<Ts>...> elements_;
+                std::array<TypedSinkBase*, sizeof...(Ts)> sinks_;
+                size_t next_{};
+        };
+
+        /*! \brief Decodes aggregates of two elements. */
+        template <typename First, typename Second>
+        class TypedSink<std::pair<First, Second>> : public TupleSink<std::pair<First, Second>, First, Second> { };
+
+        /*! \brief Decodes aggregates of exactly as many elements as the tuple has. */
+        template <typename... Ts>
+        class TypedSink<std::tuple<Ts...>> : public TupleSink<std::tuple<Ts...>, Ts...> { };
+
+
+        /*! \brief Decodes a streamed reply using a TypedSink, see TypedDecoder.
+         *
+         *  Error replies, I/O errors and type mismatches stop decoding, the rest
+         *  of the reply is still received but ignored.
+         */
+        class TypedStreamDecoder : public StreamHandler {
+        public:
+                void begin_array(Result::Type type, size_t count) override;
+                void end_array() override;
+                void string_chunk(Result::Type type, std::string_view chunk, bool last) override;
+                void integer(Result::Type type, long long value) override;
+                void floating(double value) override;
+                void nil() override;
+
+                /*! \brief Gets the outcome of decoding so far. */
+                DecodeStatus status() const { return status_; }
+
+                /*! \brief Gets the error message, if decoding failed. */
+                const std::string& error() const { return error_; }
+
+        protected:
+                /*! \brief Constructs a new decoder.
+                 *  \param root Sink for the reply itself, only stored.
+                 */
+                explicit TypedStreamDecoder(TypedSinkBase& root)
+                        : root_{root}, string_sink_{}, status_{DecodeStatus::Ok}, error_string_{} { }
+
+        private:
+                /*! \brief Returns the sink for the next element. */
+                TypedSinkBase& next_sink();
+
+                /*! \brief Notifies the enclosing aggregate that its current element is complete. */
+                void element_done();
+
+                /*! \brief Stops decoding, because \p what does not fit into \p sink. */
+                void mismatch(const TypedSinkBase& sink, const std::string& what);
+
+                /*! \brief Sink for the reply itself. */
+                TypedSinkBase& root_;
+
+                /*! \brief Sinks of the aggregates which are currently being decoded, innermost last. */
+                std::vector<TypedSinkBase*> stack_;
+
+                /*! \brief Sink receiving the current string, nullptr if not within a string. */
+                TypedSinkBase* string_sink_;
+
+                /*! \brief Outcome of decoding. */
+                DecodeStatus status_;
+
+                /*! \brief Error message if decoding failed. */
+                std::string error_;
+
+                /*! \brief Indicates if an error string is currently being received. */
+                bool error_string_;
+        };
+
+        /*! \brief Decodes a streamed reply into a value of type \p T.
+         *
+         *  Elements are decoded as they arrive, without building a Result first.
+         */
+        template <typename T>
+        class TypedDecoder : public TypedStreamDecoder {
+        public:
+                TypedDecoder() : TypedStreamDecoder{sink_} { sink_.bind(value_); }
+
+                /*! \brief Moves the decoded value out of the decoder.
+                 *  \return The decoded value, or the error.
+                 */
+                TypedResult<T> take()
+                {
+                        if (status() != DecodeStatus::Ok) {
+                                return TypedResult<T>{status(), T{}, error()};
+                        }
+
+                        return TypedResult<T>{status(), std::move(value_), {}};
+                }
+
+        private:
+                T value_{};
+                TypedSink<T> sink_;
+        };
+
+
+        /*! \brief Converts values of type \p T into command arguments.
+         *
+         *  Each specialization provides `static convert(const T& value)`, returning
+         *  either something convertible to std::string_view, an integer or a
+         *  floating point number, which is then serialized. Specialize it for
+         *  custom types, e.g.
+         *
+         *      template <>
+         *      struct resply::CommandArgument<Point> {
+         *              static std::string convert(const Point& p) { return p.to_string(); }
+         *      };
+         *
+         *  The converted value only needs to live until the command is serialized.
+         */
+        template <typename T, typename = void>
+        struct CommandArgument;
+
+        /*! \brief Strings, std::string_view, const char* and string literals. */
+        template <typename T>
+        struct CommandArgument<T, std::enable_if_t<std::is_convertible<const T&, std::string_view>::value>> {
+                static std::string_view convert(const T& value) { return value; }
+        };
+
+        /*! \brief Integers (and bool), sent in decimal notation. */
+        template <typename T>
+        struct CommandArgument<T, std::enable_if_t<std::is_integral<T>::value>> {
+                static T convert(T value) { return value; }
+        };
+
+        /*! \brief Floating point numbers, in the shortest notation which reads back exactly. */
+        template <typename T>
+        struct CommandArgument<T, std::enable_if_t<std::is_floating_point<T>::value>> {
+                /*! \brief The formatted number, formatted on the stack. */
+                struct Formatted {
+                        operator std::string_view() const { return {data.data(), length}; }
+
+                        std::array<char, 64> data;
+                        size_t length;
+                };
+
+                static Formatted convert(T value)
+                {
+                        Formatted formatted;
+                        auto end{std::to_chars(formatted.data.data(), formatted.data.data() + formatted.data.size(), value).ptr};
+                        formatted.length = end - formatted.data.data();
+
+                        return formatted;
+                }
+        };
+
+        /*! \brief Contiguous ranges of bytes, e.g. std::vector<std::byte> or std::array<uint8_t, N>, sent as-is. */
+        template <typename T>
+        struct CommandArgument<T, std::enable_if_t<
+                !std::is_convertible<const T&, std::string_view>::value &&
+                sizeof(*std::data(std::declval<const T&>())) == 1 &&
+                std::is_trivially_copyable<std::remove_reference_t<decltype(*std::data(std::declval<const T&>()))>>::value,
+                std::void_t<decltype(std::size(std::declval<const T&>()))>>> {
+                static std::string_view convert(const T& value)
+                {
+                        return {reinterpret_cast<const char*>(std::data(value)), std::size(value)};
+                }
+        };
+
+
+        /*! \brief Encodes the parts of commands in RESP. */
+        class RespEncoder {
+        public:
+                /*! \brief Number of characters of \p value in decimal notation. */
+                template <typename T>
+                static constexpr size_t decimal_length(T value)
+                {
+                        size_t length{1};
+
+                        if constexpr (std::is_signed<T>::value) {
+                                if (value < 0) {
+                                        // Not negated, which would overflow for the minimum.
+                                        length++;
+                                        value = -(value / 10);
+
+                                        if (!value) {
+                                                return length;
+                                        }
+
+                                        length++;
+                                }
+                        }
+
+                        for (; value >= 10; value /= 10) {
+                                length++;
+                        }
+
+                        return length;
+                }
+
+                /*! \brief Size of the array header announcing \p count arguments. */
+                static constexpr size_t header_size(size_t count)
+                {
+                        return 1 + decimal_length(count) + 2;
+                }
+
+                /*! \brief Size of a bulk string of \p length bytes. */
+                static constexpr size_t bulk_size(size_t length)
+                {
+                        return 1 + decimal_length(length) + 2 + length + 2;
+                }
+
+                /*! \brief Size of a string argument. */
+                static constexpr size_t argument_size(std::string_view str)
+                {
+                        return bulk_size(str.size());
+                }
+
+                /*! \brief Size of an integer argument. */
+                template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+                static constexpr size_t argument_size(T num)
+                {
+                        return bulk_size(decimal_length(+num));
+                }
+
+                /*! \brief Writes the array header announcing \p count arguments.
+                 *  \return Position after the header.
+                 */
+                static char* write_header(char* position, size_t count)
+                {
+                        *position++ = '*';
+                        position = std::to_chars(position, position + 20, count).ptr;
+                        *position++ = '\r';
+                        *position++ = '\n';
+
+                        return position;
+                }
+
+                /*! \brief Writes the length prefix of a bulk string of \p length bytes.
+                 *  \return Position of the payload.
+                 */
+                static char* write_bulk_header(char* position, size_t length)
+                {
+                        *position++ = '$';
+                        position = std::to_chars(position, position + 20, length).ptr;
+                        *position++ = '\r';
+                        *position++ = '\n';
+
+                        return position;
+                }
+
+                /*! \brief Writes a string argument.
+                 *  \return Position after the argument.
+                 */
+                static char* write_argument(char* position, std::string_view str)
+                {
+                        position = std::copy(str.cbegin(), str.cend(), write_bulk_header(position, str.size()));
+                        *position++ = '\r';
+                        *position++ = '\n';
+
+                        return position;
+                }
+
+                /*! \brief Writes an integer argument.
+                 *  \return Position after the argument.
+                 */
+                template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+                static char* write_argument(char* position, T num)
+                {
+                        position = write_bulk_header(position, decimal_length(+num));
+                        position = std::to_chars(position, position + 20, +num).ptr;
+                        *position++ = '\r';
+                        *position++ = '\n';
+
+                        return position;
+                }
+        };
+
+
+        /*! \brief A command serialized by RespCommandSerializer.
+         *
+         *  Large arguments are not copied, but referenced where they are and
+         *  sent from there (using scatter-gather I/O), so they are only valid
+         *  as long as the arguments passed to RespCommandSerializer::command.
+         */
+        class SerializedCommand {
+        public:
+                /*! \brief An argument which is referenced instead of copied. */
+                struct Reference {
+                        /*! \brief Position in #data where the argument belongs. */
+                        size_t offset;
+
+                        /*! \brief The argument itself. */
+                        std::string_view data;
+                };
+
+                /*! \brief Arguments of at least this size are referenced instead of copied. */
+                static constexpr size_t MIN_REFERENCE_SIZE = 16 * 1024;
+
+                /*! \brief Gets the serialized command, without the referenced arguments.
+                 *  \return The command, which is complete if there are no #references.
+                 */
+                const std::string& data() const { return data_; }
+
+                /*! \brief Gets the referenced arguments, ordered by their offset. */
+                const std::vector<Reference>& references() const { return references_; }
+
+                /*! \brief Indicates if the command is empty. */
+                bool empty() const { return data_.empty(); }
+
+                /*! \brief Gets the size of the complete command, including referenced arguments. */
+                size_t size() const
+                {
+                        size_t size{data_.size()};
+
+                        for (const Reference& reference: references_) {
+                                size += reference.data.size();
+                        }
+
+                        return size;
+                }
+
+                /*! \brief Appends the complete command to \p out, including referenced arguments. */
+                void append_to(std::string& out) const
+                {
+                        size_t position{};
+
+                        for (const Reference& reference: references_) {
+                                out.append(data_, position, reference.offset - position);
+                                out.append(reference.data);
+                                position = reference.offset;
+                        }
+
+                        out.append(data_, position, std::string::npos);
+                }
+
+        private:
+                template <typename R>
+                friend class RespCommandSerializer;
+
+                /*! \brief The command, without the referenced arguments. */
+                std::string data_;
+
+                /*! \brief Arguments which belong into #data_. */
+                std::vector<Reference> references_;
+        };
+
+
+        /*! \brief Marks the variable arguments of a PreparedCommand. */
+        struct Placeholder { };
+
+        /*! \brief Marks the variable arguments of a PreparedCommand. */
+        inline constexpr Placeholder placeholder{};
+
+        /*! \brief A command of which only some arguments vary between calls.
+         *  \param N Number of variable arguments.
+         *
+         *  The array header and all constant arguments are serialized once on
+         *  construction, each call to RespCommandSerializer::command only
+         *  serializes the variable arguments in between, e.g.
+         *
+         *      resply::PreparedCommand incr{"hincrby", resply::placeholder, resply::placeholder, 1};
+         *      client.command(incr, "counters:42", "visits");
+         */
+        template <size_t N>
+        class PreparedCommand {
+        public:
+                /*! \brief Constructs a new prepared command.
+                 *  \param name The name of the command.
+                 *  \param args Constant arguments (see CommandArgument) and #placeholder for variable arguments.
+                 */
+                template <typename... ArgTypes>
+                explicit PreparedCommand(const std::string& name, ArgTypes&&... args)
+                {
+                        static_assert((std::is_same<std::decay_t<ArgTypes>, Placeholder>::value + ... + 0) == N,
+                                      "N must be the number of placeholders.");
+
+                        std::string& header{segments_.front()};
+                        header.resize(RespEncoder::header_size(sizeof...(ArgTypes) + 1));
+                        RespEncoder::write_header(&header[0], sizeof...(ArgTypes) + 1);
+
+                        append(name);
+                        (append(std::forward<ArgTypes>(args)), ...);
+                }
+
+                /*! \brief Gets the serialized constant parts.
+                 *  \return The parts before, between and after the variable arguments.
+                 */
+                const std::array<std::string, N + 1>& segments() const { return segments_; }
+
+        private:
+                /*! \brief Appends a variable argument, which starts a new segment. */
+                void append(Placeholder)
+                {
+                        next_++;
+                }
+
+                /*! \brief Appends a constant argument to the current segment. */
+                template <typename T>
+                void append(T&& arg)
+                {
+                        append_converted(CommandArgument<std::remove_cv_t<std::remove_reference_t<T>>>::convert(
+                                std::forward<T>(arg)
+                        ));
+                }
+
+                /*! \brief Appends a constant argument converted by CommandArgument. */
+                template <typename T>
+                void append_converted(const T& arg)
+                {
+                        std::string& segment{segments_[next_]};
+                        const size_t size{segment.size()};
+
+                        segment.resize(size + RespEncoder::argument_size(arg));
+                        RespEncoder::write_argument(&segment[size], arg);
+                }
+
+                /*! \brief The serialized constant parts, see #segments. */
+                std::array<std::string, N + 1> segments_;
+
+                /*! \brief Index of the segment constant arguments are appended to. */
+                size_t next_{};
+        };
+
+        /*! \brief Deduces the number of variable arguments from the placeholders. */
+        template <typename... ArgTypes>
+        PreparedCommand(const std::string&, ArgTypes&&...)
+                -> PreparedCommand<(std::is_same<std::decay_t<ArgTypes>, Placeholder>::value + ... + 0)>;
+
+
+        /*! \brief Implements a template-based RESP command serializer.
+         *  \param R Return type for #command.
+         *
+         *  Commands are serialized in a single pass into a buffer of exactly
+         *  the right size, which is reused for subsequent commands. Large
+         *  arguments are referenced instead, see SerializedCommand.
+         */
+        template <typename R>
+        class RespCommandSerializer {
+        public:
+                /*! \brief Serializes a command and its parameters.
+                 *  \param str List of command name and its parameters.
+                 *  \return \p R
+                 *
+                 *  The command and parameters are automatically converted to RESP
+                 *  as specificed at <https://redis.io/topics/protocol>.
+                 */
+                R command(const std::vector<std::string>& str)
+                {
+                        SerializedCommand& command{command_buffer()};
+                        command.data_.clear();
+                        command.references_.clear();
+
+                        if (str.empty()) {
+                                return finish_command(command);
+                        }
+
+                        size_t size{RespEncoder::header_size(str.size())};
+
+                        for (const std::string& part: str) {
+                                size += argument_size(part);
+                        }
+
+                        command.data_.resize(size);
+                        char* position{RespEncoder::write_header(&command.data_[0], str.size())};
+
+                        for (const std::string& part: str) {
+                                position = write_argument(command, position, part);
+                        }
+
+                        return finish_command(command);
+                }
+
+                /*! \brief Serializes a command and its parameters.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments, see CommandArgument for the supported types.
+                 *  \return \p R
+                 *
+                 *  The command and parameters are automatically converted to RESP
+                 *  as specificed at <https://redis.io/topics/protocol>.
+                 */
+                template <typename... ArgTypes>
+                R command(const std::string& str, ArgTypes&&... args)
+                {
+                        return serialize(str, CommandArgument<
+                                std::remove_cv_t<std::remove_reference_t<ArgTypes>>
+                        >::convert(std::forward<ArgTypes>(args))...);
+                }
+
+                /*! \brief Serializes a prepared command.
+                 *  \param prepared The prepared command.
+                 *  \param args The variable arguments, see CommandArgument for the supported types.
+                 *  \return \p R
+                 */
+                template <size_t N, typename... ArgTypes>
+                R command(const PreparedCommand<N>& prepared, ArgTypes&&... args)
+                {
+                        static_assert(sizeof...(ArgTypes) == N, "Wrong number of arguments for the prepared command.");
+
+                        return serialize(prepared, CommandArgument<
+                                std::remove_cv_t<std::remove_reference_t<ArgTypes>>
+                        >::convert(std::forward<ArgTypes>(args))...);
+                }
+
+        protected:
+                /*! \brief Finishes a commmand. Semantics depend on derived class.
+                 *  \param command The serialized command.
+                 *  \return \p R
+                 *
+                 *  This method must be implemented by the derived class.
+                 */
+                virtual R finish_command(const SerializedCommand& command) = 0;
+
+                /*! \brief Gets the buffer commands are serialized into.
+                 *  \return The buffer, by default owned by this serializer.
+                 *
+                 *  Clients wrapping another one override this to share its buffer,
+                 *  so only one buffer is used per connection.
+                 */
+                virtual SerializedCommand& command_buffer() { return buffer_; }
+
+        private:
+                /*! \brief Serializes a command whose arguments are converted by CommandArgument. */
+                template <typename... ArgTypes>
+                R serialize(const std::string& str, const ArgTypes&... args)
+                {
+                        SerializedCommand& command{command_buffer()};
+                        command.data_.clear();
+                        command.references_.clear();
+
+                        if (str.empty()) {
+                                return finish_command(command);
+                        }
+
+                        constexpr size_t count{sizeof...(ArgTypes) + 1};
+                        command.data_.resize(
+                                RespEncoder::header_size(count) + argument_size(str) + (argument_size(args) + ... + 0)
+                        );
+
+                        [[maybe_unused]] char* position{
+                                write_argument(command, RespEncoder::write_header(&command.data_[0], count), str)
+                        };
+                        ((position = write_argument(command, position, args)), ...);
+
+                        return finish_command(command);
+                }
+
+                /*! \brief Serializes a prepared command whose arguments are converted by CommandArgument. */
+                template <size_t N, typename... ArgTypes>
+                R serialize(const PreparedCommand<N>& prepared, const ArgTypes&... args)
+                {
+                        SerializedCommand& command{command_buffer()};
+                        command.references_.clear();
+
+                        const std::array<std::string, N + 1>& segments{prepared.segments()};
+                        size_t size{(argument_size(args) + ... + 0)};
+
+                        for (const std::string& segment: segments) {
+                                size += segment.size();
+                        }
+
+                        command.data_.resize(size);
+
+                        [[maybe_unused]] char* position{
+                                std::copy(segments[0].cbegin(), segments[0].cend(), &command.data_[0])
+                        };
+                        [[maybe_unused]] size_t next{1};
+
+                        ((position = write_argument(command, position, args),
+                          position = std::copy(segments[next].cbegin(), segments[next].cend(), position),
+                          next++), ...);
+
+                        return finish_command(command);
+                }
+
+                /*! \brief Size of a string argument, without its data if it is referenced. */
+                static size_t argument_size(std::string_view str)
+                {
+                        const size_t size{RespEncoder::argument_size(str)};
+
+                        return str.size() < SerializedCommand::MIN_REFERENCE_SIZE ? size : size - str.size();
+                }
+
+                /*! \brief Size of an integer argument. */
+                template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+                static constexpr size_t argument_size(T num)
+                {
+                        return RespEncoder::argument_size(num);
+                }
+
+                /*! \brief Writes a string argument, or references it if it is large.
+                 *  \return Position after the argument.
+                 */
+                static char* write_argument(SerializedCommand& command, char* position, std::string_view str)
+                {
+                        if (str.size() < SerializedCommand::MIN_REFERENCE_SIZE) {
+                                return RespEncoder::write_argument(position, str);
+                        }
+
+                        position = RespEncoder::write_bulk_header(position, str.size());
+                        command.references_.push_back({static_cast<size_t>(position - command.data_.data()), str});
+                        *position++ = '\r';
+                        *position++ = '\n';
+
+                        return position;
+                }
+
+                /*! \brief Writes an integer argument.
+                 *  \return Position after the argument.
+                 */
+                template <typename T, typename = std::enable_if_t<std::is_integral<T>::value>>
+                static char* write_argument(SerializedCommand&, char* position, T num)
+                {
+                        return RespEncoder::write_argument(position, num);
+                }
+
+                /*! \brief Buffer commands are serialized into, see #command_buffer. */
+                SerializedCommand buffer_;
+        };
+
+        /*! \brief Function signature for the replies of an asynchronously sent Client::Pipeline. */
+        typedef std::function<void(std::vector<Result> replies)> PipelineCallback;
+
+        class ClientImpl;
+
+        /*! \brief Cancels pending asynchronous commands, see AsyncOptions.
+         *
+         *  Can be shared by any number of commands and cancelled from any thread.
+         */
+        class CancellationSignal {
+        public:
+                CancellationSignal();
+                ~CancellationSignal();
+
+                CancellationSignal(const CancellationSignal&) = delete;
+                CancellationSignal& operator=(const CancellationSignal&) = delete;
+
+                /*! \brief Cancels all pending commands using this signal, as well as any later ones.
+                 *
+                 *  Their callbacks receive a Type::IOError result, the replies
+                 *  are discarded once they arrive.
+                 */
+                void cancel();
+
+                /*! \brief Indicates if #cancel has been called.
+                 *  \return If this signal is cancelled.
+                 */
+                bool cancelled() const;
+
+        private:
+                friend class ClientImpl;
+
+                /*! \brief Registers \p handler to be called on #cancel.
+                 *  \return An id for #remove, or zero if already cancelled.
+                 */
+                size_t add(std::function<void()> handler);
+
+                /*! \brief Unregisters the handler with the given \p id. */
+                void remove(size_t id);
+
+                struct State;
+
+                /*! \brief Handlers and cancellation state, guarded by a mutex. */
+                std::unique_ptr<State> state_;
+        };
+
+        /*! \brief Options for asynchronous commands, see Client::command_async. */
+        struct AsyncOptions {
+                /*! \brief Time after which the command fails with a Type::Timeout result, zero for
+                 *         the command timeout of the client, see Client::command_timeout.
+                 *
+                 *  The reply is discarded once it arrives.
+                 */
+                std::chrono::milliseconds deadline{};
+
+                /*! \brief Signal to cancel the command, may be empty. */
+                std::shared_ptr<CancellationSignal> cancellation;
+        };
+
+        /*! \brief Redis client interface
+         *
+         *  This class implements the RESP to communicate with a redis server.
+         */
+        class Client : public RespCommandSerializer<Result> {
+        public:
+                /*! \brief A pipelined redis client.
+                 *
+                 *  This type of client will reject any {P}{UN}SUBSCIBRE commands.
+                 */
+                class Pipeline : public RespCommandSerializer<Pipeline&> {
+                public:
+                        /*! \brief Constructs a new pipelined client.
+                         *  \param client A connected redis client.
+                         */
+                        Pipeline(Client& client) : client_{client}, count_{}, timeout_{} { }
+
+                        /*! \brief Sets the total time for sending the batch and receiving all replies.
+                         *  \param timeout The deadline, zero to use Client::command_timeout for the whole batch.
+                         *  \return The pipelined client.
+                         *
+                         *  Replies which did not arrive in time are of Type::Timeout,
+                         *  the connection is closed then, see Client::command_timeout.
+                         */
+                        Pipeline& timeout(std::chrono::milliseconds timeout)
+                        {
+                                timeout_ = timeout;
+                                return *this;
+                        }
+
+                        /*! \brief Sends the batch of commands to the server.
+                         *  \return The results of the commands.
+                         */
+                        std::vector<Result> send();
+
+                        /*! \brief Sends the batch of commands to the server.
+                         *  \param arena Arena to allocate the results from.
+                         *  \return The results of the commands, valid as long as \p arena.
+                         */
+                        std::vector<ResultView> send(ResultArena& arena);
+
+                        /*! \brief Sends the batch of commands to the server.
+                         *  \return The replies decoded into \p T, as if they were the elements of one array.
+                         *
+                         *  E.g. `std::vector<long long>` for a batch of INCR commands, or
+                         *  `std::tuple<std::string, std::optional<std::string>>` for a SET and a GET.
+                         */
+                        template <typename T>
+                        TypedResult<T> send_as()
+                        {
+                                TypedDecoder<T> decoder;
+                                send(decoder);
+
+                                return decoder.take();
+                        }
+
+                        /*! \brief Sends the batch of commands to the server without waiting for the replies.
+                         *  \param callback Receives the results of the commands, on the io_context of the client.
+                         *  \param options Deadline and cancellation of the whole batch.
+                         *
+                         *  See Client::command_async.
+                         */
+                        void send_async(PipelineCallback callback, const AsyncOptions& options={});
+
+                private:
+                        /*! \brief Sends the batch of commands to the server and streams the replies
+                         *         to \p handler, wrapped in a single array.
+                         */
+                        void send(StreamHandler& handler);
+
+                        /*! \brief Adds the command to the batch.
+                         *  \param command Command to add.
+                         *  \return The pipelined client.
+                         */
+                        Pipeline& finish_command(const SerializedCommand& command) override;
+
+                        /*! \brief Serializes into the buffer of #client_. */
+                        SerializedCommand& command_buffer() override { return client_.command_buffer(); }
+
+                        /*! \brief Discards the batch of commands. */
+                        void clear();
+
+                        /*! \brief Redis client connection this pipeline will use. */
+                        Client& client_;
+
+                        /*! \brief The batch of commands to send, serialized back to back. */
+                        std::string commands_;
+
+                        /*! \brief Number of commands in #commands_. */
+                        size_t count_;
+
+                        /*! \brief Deadline of the whole batch, see #timeout. */
+                        std::chrono::milliseconds timeout_;
+                };
+
+                /*! \brief A pipelined redis client for batches of unlimited size.
+                 *
+                 *  Commands are sent automatically as soon as enough of them are
+                 *  buffered, and replies are passed to a callback while further
+                 *  commands are queued. At most a fixed number of commands are
+                 *  in flight (sent, but not yet answered), which bounds the memory
+                 *  used on both the client and the server, e.g. for bulk imports.
+                 *
+                 *  Like Pipeline, this rejects any {P}{UN}SUBSCRIBE commands.
+                 */
+                class StreamingPipeline : public RespCommandSerializer<StreamingPipeline&> {
+                public:
+                        /*! \brief Constructs a new streaming pipeline.
+                         *  \param client A connected redis client, which must not be used otherwise
+                         *                until #finish is called.
+                         *  \param callback Receives the replies in order, each only valid during the call.
+                         *  \param flush_commands Number of buffered commands which are sent at once.
+                         *  \param flush_bytes Size of buffered commands which are sent at once.
+                         *  \param max_in_flight Maximum number of commands without reply.
+                         */
+                        StreamingPipeline(Client& client, ReplyCallback callback, size_t flush_commands=256,
+                                          size_t flush_bytes=64 * 1024, size_t max_in_flight=4096);
+
+                        StreamingPipeline(const StreamingPipeline&) = delete;
+                        StreamingPipeline& operator=(const StreamingPipeline&) = delete;
+
+                        /*! \brief Sends all remaining commands and waits for their replies, see #finish. */
+                        ~StreamingPipeline();
+
+                        /*! \brief Sends all buffered commands.
+                         *
+                         *  Replies which already arrived are passed to the callback, also
+                         *  while the commands are written, so even large batches can't fill
+                         *  the socket buffers in both directions. If too many commands are
+                         *  in flight, this waits for their replies.
+                         */
+                        void flush();
+
+                        /*! \brief Sends all buffered commands and waits for all replies. */
+                        void finish();
+
+                        /*! \brief Gets the number of sent commands without reply.
+                         *  \return The number of commands in flight.
+                         */
+                        size_t in_flight() const { return in_flight_; }
+
+                private:
+                        /*! \brief Buffers the command, and sends the buffer if it is full.
+                         *  \param command Command to add.
+                         *  \return The streaming pipeline.
+                         */
+                        StreamingPipeline& finish_command(const SerializedCommand& command) override;
+
+                        /*! \brief Serializes into the buffer of #client_. */
+                        SerializedCommand& command_buffer() override { return client_.command_buffer(); }
+
+                        /*! \brief Passes replies to #callback_.
+                         *  \param min Number of replies to wait for.
+                         *
+                         *  Further replies are passed on as long as they are available
+                         *  without waiting.
+                         */
+                        void receive(size_t min);
+
+                        /*! \brief Redis client connection this pipeline will use. */
+                        Client& client_;
+
+                        /*! \brief Receives the replies. */
+                        ReplyCallback callback_;
+
+                        /*! \brief Number of buffered commands which triggers #flush. */
+                        const size_t flush_commands_;
+
+                        /*! \brief Size of buffered commands which triggers #flush. */
+                        const size_t flush_bytes_;
+
+                        /*! \brief Maximum number of commands without reply. */
+                        const size_t max_in_flight_;
+
+                        /*! \brief Buffered commands, serialized back to back. */
+                        std::string commands_;
+
+                        /*! \brief Number of commands in #commands_. */
+                        size_t count_;
 
-                /*! \brief Specialization of #command for ending recursion. */
-                R command(const std::stringstream& builder)
-                {
-                        return finish_command(builder.str());
-                }
+                        /*! \brief Number of sent commands without reply. */
+                        size_t in_flight_;
+                };
 
-        protected:
-                /*! \brief Finishes a commmand. Semantics depend on derived class.
-                 *  \param command The serialized command.
-                 *  \return \p R
+                /*! \brief A redis client which allocates results from a ResultArena.
                  *
-                 *  This method must be implemented by the derived class.
+                 *  Large replies (e.g. LRANGE of many elements) then cost a few
+                 *  allocations instead of one or more per element.
                  */
-                virtual R finish_command(const std::string& command) = 0;
-        };
+                class ArenaClient : public RespCommandSerializer<ResultView> {
+                public:
+                        /*! \brief Constructs a new arena-backed client.
+                         *  \param client A connected redis client.
+                         *  \param arena Arena to allocate the results from.
+                         */
+                        ArenaClient(Client& client, ResultArena& arena) : client_{client}, arena_{arena} { }
 
-        class ClientImpl;
+                private:
+                        /*! \brief Sends the command to the server.
+                         *  \param command The command to send.
+                         *  \return The result of the command, valid as long as #arena_.
+                         */
+                        ResultView finish_command(const SerializedCommand& command) override;
 
-        /*! \brief Redis client interface
-         *
-         *  This class implements the RESP to communicate with a redis server.
-         */
-        class Client : public RespCommandSerializer<Result> {
-        public:
-                /*! \brief A pipelined redis client.
+                        /*! \brief Serializes into the buffer of #client_. */
+                        SerializedCommand& command_buffer() override { return client_.command_buffer(); }
+
+                        /*! \brief Redis client connection this client will use. */
+                        Client& client_;
+
+                        /*! \brief Arena the results are allocated from. */
+                        ResultArena& arena_;
+                };
+
+                /*! \brief A redis client which returns results referencing its receive buffer.
                  *
-                 *  This type of client will reject any {P}{UN}SUBSCIBRE commands.
+                 *  Strings are not copied at all, which suits paths that only
+                 *  inspect or forward the replies. The results stay valid until the
+                 *  next command is sent using the same Client, use ResultView::to_owned
+                 *  to keep them longer.
                  */
-                class Pipeline : public RespCommandSerializer<Pipeline&> {
+                class ViewClient : public RespCommandSerializer<ResultView> {
                 public:
-                        /*! \brief Constructs a new pipelined client.
+                        /*! \brief Constructs a new view client.
                          *  \param client A connected redis client.
                          */
-                        Pipeline(Client& client) : client_{client} { }
-
-                        /*! \brief Sends the batch of commands to the server.
-                         *  \return The results of the commands.
-                         */
-                        std::vector<Result> send();
+                        ViewClient(Client& client) : client_{client} { }
 
                 private:
-                        /*! \brief Adds the command to the batch.
-                         *  \param command Command to add.
-                         *  \return The pipelined client.
+                        /*! \brief Sends the command to the server.
+                         *  \param command The command to send.
+                         *  \return The result of the command, valid until the next command.
                          */
-                        Pipeline& finish_command(const std::string& command) override;
+                        ResultView finish_command(const SerializedCommand& command) override;
 
-                        /*! \brief Redis client connection this pipeline will use. */
-                        Client& client_;
+                        /*! \brief Serializes into the buffer of #client_. */
+                        SerializedCommand& command_buffer() override { return client_.command_buffer(); }
 
-                        /*! \brief The batch of commands to send. */
-                        std::vector<std::string> commands_;
+                        /*! \brief Redis client connection this client will use. */
+                        Client& client_;
                 };
 
                 /*! \brief Represents a pipelined redis client. */
                 friend class Pipeline;
 
+                /*! \brief Represents a streaming pipelined redis client. */
+                friend class StreamingPipeline;
+
+                /*! \brief Represents an arena-backed redis client. */
+                friend class ArenaClient;
+
+                /*! \brief Represents a redis client returning views. */
+                friend class ViewClient;
+
+                /*! \brief Runs this client on its own I/O thread. */
+                friend class MultiplexedClient;
+
                 /*! \brief Constructs a new redis client which connects to localhost:6379. */
                 Client();
 
                 /*! \brief Constructs a new redis client.
                  *  \param address Redis server address in the format "<host>[:<port>]".
                  *                 The ":port" component may be omitted, in which case it defaults to "6379".
+                 *                 A server on the same host can be reached over its unix domain socket
+                 *                 instead, with an address like "unix:///var/run/redis.sock".
                  *  \param timeout Timeout in milliseconds when connecting to server. Default are 500ms.
                  */
                 explicit Client(const std::string& address, size_t timeout=500);
@@ -214,6 +1758,20 @@ namespace resply {
                   */
                 Client(const std::string& host, const std::string& port, size_t timeout=500);
 
+                /*! \brief Constructs a new redis client, which runs on \p io_context.
+                 *  \param io_context Context which runs the handlers of asynchronous commands,
+                 *                    e.g. shared by many clients and run by a small pool of threads.
+                 *  \param address Redis server address in the format "<host>[:<port>]" or "unix://<path>".
+                 *  \param timeout Timeout in milliseconds when connecting to server. Default are 500ms.
+                 *
+                 *  #connect does not need \p io_context to be run, so it may be run only afterwards.
+                 *  Synchronous commands however only time out (see #command_timeout) while
+                 *  \p io_context is run by some other thread. With a timeout, a synchronous command
+                 *  issued from a handler on \p io_context (e.g. a callback of #command_async)
+                 *  fails right away with a Type::IOError result, as it would wait for itself.
+                 */
+                Client(asio::io_context& io_context, const std::string& address, size_t timeout=500);
+
                 /*! \brief Closes the connection to the redis server. */
                 ~Client();
 
@@ -227,12 +1785,12 @@ namespace resply {
                 void close();
 
                 /*! \brief Retrieves the address of the server this client is connected to.
-                 *  \return The server address of the redis server.
+                 *  \return The server address of the redis server, or the path of its unix domain socket.
                  */
                 const std::string& host() const;
 
                 /*! \brief Retrieves the port of the server this client is connected to.
-                 *  \return The server port of the redis server.
+                 *  \return The server port of the redis server, empty for a unix domain socket.
                  */
                 const std::string& port() const;
 
@@ -241,6 +1799,49 @@ namespace resply {
                  */
                 bool is_connected() const;
 
+                /*! \brief Gets the RESP version used on this connection.
+                 *  \return Either 2 or 3.
+                 */
+                int protocol_version() const;
+
+                /*! \brief Sets the RESP version to use on this connection.
+                 *  \param version Either 2 or 3.
+                 *
+                 *  The version is negotiated with HELLO on #connect, or immediately
+                 *  if already connected. If the server does not support RESP3
+                 *  (redis < 6.0), the client falls back to RESP2.
+                 *  With RESP3, replies can contain the additional types Type::Map,
+                 *  Type::Set, Type::Double, Type::Boolean and Type::BigNumber.
+                 */
+                void protocol_version(int version);
+
+                /*! \brief Gets the time after which a command fails, see #command_timeout(std::chrono::milliseconds).
+                 *  \return The timeout, zero for none.
+                 */
+                std::chrono::milliseconds command_timeout() const;
+
+                /*! \brief Sets the time after which a command fails with a Type::Timeout result.
+                 *  \param timeout The timeout for sending a command and receiving its reply, zero for none.
+                 *
+                 *  Bounds each command, e.g. against a stalled server, instead of
+                 *  waiting forever. As the reply might still arrive afterwards,
+                 *  the connection is closed on a timeout and must be reestablished
+                 *  with #connect. Also the default deadline of asynchronous commands,
+                 *  streaming pipelines wait at most this long for each batch of replies.
+                 *  Defaults to none, #listen_for_messages never times out.
+                 */
+                void command_timeout(std::chrono::milliseconds timeout);
+
+                /*! \brief Sets the callback for out-of-band push messages.
+                 *  \param callback Callback receiving the Type::Push result.
+                 *  \return The client.
+                 *
+                 *  Only used with RESP3, where the server may interleave push messages
+                 *  (e.g. client-side caching invalidations) with regular replies.
+                 *  Pub/sub messages are delivered to the channel callbacks instead.
+                 */
+                Client& on_push(PushCallback callback);
+
                 /*! \brief Creates a new pipelined client using this client.
                  *  \return A pipelined client.
                  */
@@ -248,6 +1849,185 @@ namespace resply {
                         return Pipeline(*this);
                 }
 
+                /*! \brief Creates a new streaming pipelined client using this client.
+                 *  \param callback Receives the replies in order.
+                 *  \return A streaming pipelined client, see StreamingPipeline for the parameters.
+                 */
+                StreamingPipeline streaming(ReplyCallback callback, size_t flush_commands=256,
+                                            size_t flush_bytes=64 * 1024, size_t max_in_flight=4096) {
+                        return StreamingPipeline(*this, callback, flush_commands, flush_bytes, max_in_flight);
+                }
+
+                /*! \brief Creates a new client using this client, which allocates results from \p arena.
+                 *  \param arena Arena to allocate the results from.
+                 *  \return An arena-backed client.
+                 */
+                ArenaClient in(ResultArena& arena) {
+                        return ArenaClient(*this, arena);
+                }
+
+                /*! \brief Creates a new client using this client, which returns views into the receive buffer.
+                 *  \return A client returning views.
+                 */
+                ViewClient view() {
+                        return ViewClient(*this);
+                }
+
+                /*! \brief Sends a command and streams its reply to \p handler.
+                 *  \param handler Handler receiving the elements of the reply.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments.
+                 *
+                 *  The elements are reported while the reply is received, so even
+                 *  huge replies (e.g. LRANGE of millions of elements) only need
+                 *  constant memory. With RESP3, push messages arriving before the
+                 *  reply are streamed to \p handler as well, as Type::Push.
+                 */
+                template <typename... ArgTypes>
+                void command_stream(StreamHandler& handler, const std::string& str, ArgTypes&&... args)
+                {
+                        StreamClient{*this, handler}.command(str, std::forward<ArgTypes>(args)...);
+                }
+
+                /*! \brief Sends a command and streams its reply to \p handler.
+                 *  \param handler Handler receiving the elements of the reply.
+                 *  \param str List of command name and its parameters.
+                 */
+                void command_stream(StreamHandler& handler, const std::vector<std::string>& str)
+                {
+                        StreamClient{*this, handler}.command(str);
+                }
+
+                /*! \brief Sends a command and decodes its reply into \p T.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments.
+                 *  \return The decoded reply, or why it could not be decoded.
+                 *
+                 *  The reply is decoded while it is received, without building a Result.
+                 *  Supported are integers, bool, floating point numbers, std::string,
+                 *  and std::optional (nil), std::vector, maps (std::map, std::unordered_map),
+                 *  std::pair and std::tuple of these, e.g.
+                 *  `command_as<std::unordered_map<std::string, long long>>("hgetall", "key")`.
+                 */
+                template <typename T, typename... ArgTypes>
+                TypedResult<T> command_as(const std::string& str, ArgTypes&&... args)
+                {
+                        TypedDecoder<T> decoder;
+                        StreamClient{*this, decoder, true}.command(str, std::forward<ArgTypes>(args)...);
+
+                        return decoder.take();
+                }
+
+                /*! \brief Sends a command and decodes its reply into \p T.
+                 *  \param str List of command name and its parameters.
+                 *  \return The decoded reply, or why it could not be decoded.
+                 */
+                template <typename T>
+                TypedResult<T> command_as(const std::vector<std::string>& str)
+                {
+                        TypedDecoder<T> decoder;
+                        StreamClient{*this, decoder, true}.command(str);
+
+                        return decoder.take();
+                }
+
+                /*! \brief Sends a command without waiting for its reply.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments.
+                 *  \return The future result of the command.
+                 *
+                 *  The command is written and its reply is read by handlers on the
+                 *  io_context of this client, so it completes only while the io_context
+                 *  is run, see #run. Any number of commands may be pending at once,
+                 *  they are pipelined on the connection. Unlike all other methods,
+                 *  this is safe to call from multiple threads at once, see MultiplexedClient.
+                 *  The client must not be destroyed and no synchronous commands must
+                 *  be sent while any asynchronous command is pending.
+                 *  Pub/sub commands are not supported.
+                 */
+                template <typename... ArgTypes>
+                std::future<Result> command_async(const std::string& str, ArgTypes&&... args)
+                {
+                        auto promise{std::make_shared<std::promise<Result>>()};
+                        std::future<Result> future{promise->get_future()};
+
+                        AsyncClient{*this, [promise](const Result& reply) {
+                                promise->set_value(reply);
+                        }}.command(str, std::forward<ArgTypes>(args)...);
+
+                        return future;
+                }
+
+                /*! \brief Sends a command without waiting for its reply.
+                 *  \param str List of command name and its parameters.
+                 *  \return The future result of the command.
+                 */
+                std::future<Result> command_async(const std::vector<std::string>& str)
+                {
+                        auto promise{std::make_shared<std::promise<Result>>()};
+                        std::future<Result> future{promise->get_future()};
+
+                        AsyncClient{*this, [promise](const Result& reply) {
+                                promise->set_value(reply);
+                        }}.command(str);
+
+                        return future;
+                }
+
+                /*! \brief Sends a command without waiting for its reply.
+                 *  \param callback Completion handler receiving the reply, which is invoked
+                 *                  on the io_context of this client.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments.
+                 *
+                 *  See #command_async(const std::string&, ArgTypes&&...).
+                 */
+                template <typename... ArgTypes>
+                void command_async(ReplyCallback callback, const std::string& str, ArgTypes&&... args)
+                {
+                        AsyncClient{*this, callback}.command(str, std::forward<ArgTypes>(args)...);
+                }
+
+                /*! \brief Sends a command without waiting for its reply.
+                 *  \param callback Completion handler receiving the reply.
+                 *  \param str List of command name and its parameters.
+                 */
+                void command_async(ReplyCallback callback, const std::vector<std::string>& str)
+                {
+                        AsyncClient{*this, callback}.command(str);
+                }
+
+                /*! \brief Sends a command without waiting for its reply.
+                 *  \param callback Completion handler receiving the reply.
+                 *  \param options Deadline and cancellation of the command.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments.
+                 */
+                template <typename... ArgTypes>
+                void command_async(ReplyCallback callback, const AsyncOptions& options,
+                                   const std::string& str, ArgTypes&&... args)
+                {
+                        AsyncClient{*this, callback, options}.command(str, std::forward<ArgTypes>(args)...);
+                }
+
+                /*! \brief Sends a command without waiting for its reply.
+                 *  \param callback Completion handler receiving the reply.
+                 *  \param options Deadline and cancellation of the command.
+                 *  \param str List of command name and its parameters.
+                 */
+                void command_async(ReplyCallback callback, const AsyncOptions& options,
+                                   const std::vector<std::string>& str)
+                {
+                        AsyncClient{*this, callback, options}.command(str);
+                }
+
+                /*! \brief Runs the io_context of this client until no asynchronous command is pending.
+                 *
+                 *  Only needed if the client was not constructed with an io_context,
+                 *  which is run elsewhere anyway.
+                 */
+                void run();
+
                 /*! \brief Indicates if the client is currently subscribed to any channels.
                  *  \return If the client is in subscription-mode.
                  *
@@ -297,12 +2077,265 @@ namespace resply {
                  *  \param command The command to send.
                  *  \return The result of the command.
                  */
-                Result finish_command(const std::string& command) override;
+                Result finish_command(const SerializedCommand& command) override;
+
+                /*! \brief Streams the reply of a command to a StreamHandler. */
+                class StreamClient : public RespCommandSerializer<void> {
+                public:
+                        /*! \param dispatch_pushes If push messages go to their callbacks instead of \p handler. */
+                        StreamClient(Client& client, StreamHandler& handler, bool dispatch_pushes=false)
+                                : client_{client}, handler_{handler}, dispatch_pushes_{dispatch_pushes} { }
+
+                private:
+                        void finish_command(const SerializedCommand& command) override;
+                        SerializedCommand& command_buffer() override { return client_.command_buffer(); }
+
+                        Client& client_;
+                        StreamHandler& handler_;
+                        const bool dispatch_pushes_;
+                };
+
+                /*! \brief Sends a command asynchronously, passing its reply to a callback. */
+                class AsyncClient : public RespCommandSerializer<void> {
+                public:
+                        AsyncClient(Client& client, ReplyCallback callback, const AsyncOptions& options={})
+                                : client_{client}, callback_{std::move(callback)}, options_{options} { }
+
+                private:
+                        /*! \brief Sends the command, serialized into the own buffer of this
+                         *         client, so any number of threads can do so at once.
+                         */
+                        void finish_command(const SerializedCommand& command) override;
+
+                        Client& client_;
+                        ReplyCallback callback_;
+                        const AsyncOptions options_;
+                };
 
                 /*! \brief Internal client implementation. */
                 std::unique_ptr<ClientImpl> impl_;
         };
 
+        /*! \brief A redis client which can be shared by any number of threads.
+         *
+         *  Commands of all threads are queued without locking and sent by a
+         *  single I/O thread, which writes everything queued at once and matches
+         *  the replies to the commands in order. This pipelines the commands
+         *  of concurrent threads on a single connection, without any thread
+         *  waiting for the round trip of the others.
+         */
+        class MultiplexedClient {
+        public:
+                /*! \brief Constructs a new multiplexed client and starts its I/O thread.
+                 *  \param address Redis server address in the format "<host>[:<port>]" or "unix://<path>".
+                 *  \param timeout Timeout in milliseconds when connecting to server. Default are 500ms.
+                 */
+                explicit MultiplexedClient(const std::string& address="localhost", size_t timeout=500);
+
+                MultiplexedClient(const MultiplexedClient&) = delete;
+                MultiplexedClient& operator=(const MultiplexedClient&) = delete;
+
+                /*! \brief Stops the I/O thread.
+                 *
+                 *  Commands still waiting for their reply fail with a Type::IOError result.
+                 */
+                ~MultiplexedClient();
+
+                /*! \brief Establishes a connection to the server, before sending any commands. */
+                void connect() { client_.connect(); }
+
+                /*! \brief Checks if the client is connected to a redis server.
+                 *  \return If the client is connected.
+                 */
+                bool is_connected() const { return client_.is_connected(); }
+
+                /*! \brief Sends a command and waits for its reply.
+                 *  \param str The name of the command.
+                 *  \param args A series of command arguments.
+                 *  \return The result of the command.
+                 *
+                 *  Must not be called from the I/O thread, e.g. in a callback of #command_async,
+                 *  which would wait for itself. It then fails right away with a Type::IOError result.
+                 */
+                template <typename... ArgTypes>
+                Result command(const std::string& str, ArgTypes&&... args)
+                {
+                        if (on_io_thread()) {
+                                return Result{Result::Type::IOError, BLOCKING_ON_IO_THREAD};
+                        }
+
+                        return client_.command_async(str, std::forward<ArgTypes>(args)...).get();
+                }
+
+                /*! \brief Sends a command and waits for its reply.
+                 *  \param str List of command name and its parameters.
+                 *  \return The result of the command.
+                 *
+                 *  Must not be called from the I/O thread, see #command.
+                 */
+                Result command(const std::vector<std::string>& str)
+                {
+                        if (on_io_thread()) {
+                                return Result{Result::Type::IOError, BLOCKING_ON_IO_THREAD};
+                        }
+
+                        return client_.command_async(str).get();
+                }
+
+                /*! \brief Sends a command without waiting for its reply, see Client::command_async.
+                 *  \param args The arguments of Client::command_async, including an optional callback.
+                 */
+                template <typename... ArgTypes>
+                auto command_async(ArgTypes&&... args)
+                {
+                        return client_.command_async(std::forward<ArgTypes>(args)...);
+                }
+
+        private:
+                /*! \brief Error message of #command on the I/O thread. */
+                static constexpr const char* BLOCKING_ON_IO_THREAD = "Blocking command on the I/O thread.";
+
+                /*! \return If called from the I/O thread. */
+                bool on_io_thread() const;
+
+                /*! \brief The io_context and the I/O thread running it. */
+                struct Loop;
+
+                /*! \brief Must precede #client_, which runs on it. */
+                std::unique_ptr<Loop> loop_;
+
+                /*! \brief The client, of which only the thread-safe Client::command_async is used. */
+                Client client_;
+        };
+
+        /*! \brief Options of a ClientPool. */
+        struct ClientPoolOptions {
+                /*! \brief Number of connections which are kept open, even if idle. */
+                size_t min_size{1};
+
+                /*! \brief Maximum number of connections. */
+                size_t max_size{16};
+
+                /*! \brief How long ClientPool::acquire waits if all connections are in use. */
+                std::chrono::milliseconds wait_timeout{1000};
+
+                /*! \brief Interval of checking idle connections with PING, zero to disable.
+                 *
+                 *  A connection which does not answer within the interval fails the check.
+                 */
+                std::chrono::milliseconds health_check_interval{5000};
+
+                /*! \brief Time after which idle connections beyond #min_size are closed, zero to disable. */
+                std::chrono::milliseconds idle_timeout{60000};
+
+                /*! \brief Keeps released connections in a lock-free slot per thread, so
+                 *         threads which acquire and release repeatedly avoid the lock.
+                 */
+                bool thread_affinity{false};
+        };
+
+        /*! \brief A thread-safe pool of connected redis clients.
+         *
+         *  Released clients are handed out again last in, first out, so few
+         *  connections stay in use and hot. A background thread checks idle
+         *  connections for health and closes those idle for too long.
+         */
+        class ClientPool {
+        public:
+                /*! \brief An acquired client, which is returned to the pool on destruction. */
+                class Handle {
+                public:
+                        /*! \brief Constructs an empty handle. */
+                        Handle() : pool_{}, client_{} { }
+
+                        Handle(Handle&& other) noexcept : pool_{other.pool_}, client_{other.client_}
+                        {
+                                other.client_ = nullptr;
+                        }
+
+                        Handle& operator=(Handle&& other) noexcept
+                        {
+                                if (this != &other) {
+                                        reset();
+                                        pool_ = other.pool_;
+                                        client_ = other.client_;
+                                        other.client_ = nullptr;
+                                }
+
+                                return *this;
+                        }
+
+                        /*! \brief Returns the client to the pool. */
+                        ~Handle() { reset(); }
+
+                        /*! \brief Returns the client to the pool, leaving this handle empty. */
+                        void reset();
+
+                        /*! \brief Indicates if this handle holds a client.
+                         *  \return False if ClientPool::acquire timed out or could not connect.
+                         */
+                        explicit operator bool() const { return client_; }
+
+                        Client& operator*() const { return *client_; }
+                        Client* operator->() const { return client_; }
+
+                        /*! \brief Allows passing the handle to anything expecting a `Client&`. */
+                        operator Client&() const { return *client_; }
+
+                private:
+                        friend class ClientPool;
+
+                        Handle(ClientPool* pool, Client* client) : pool_{pool}, client_{client} { }
+
+                        ClientPool* pool_;
+                        Client* client_;
+                };
+
+                /*! \brief Constructs a new pool and opens ClientPoolOptions::min_size connections.
+                 *  \param address Redis server address in the format "<host>[:<port>]" or "unix://<path>".
+                 *  \param options Size and timeouts of the pool.
+                 */
+                explicit ClientPool(const std::string& address="localhost", const ClientPoolOptions& options={});
+
+                ClientPool(const ClientPool&) = delete;
+                ClientPool& operator=(const ClientPool&) = delete;
+
+                /*! \brief Closes all connections, all handles must have been released before. */
+                ~ClientPool();
+
+                /*! \brief Acquires a connected client.
+                 *  \return The client, or an empty handle if none became available within
+                 *          ClientPoolOptions::wait_timeout or a new connection failed.
+                 *
+                 *  The client must be in the same state when released, e.g. not in a
+                 *  transaction or subscribed, otherwise it should be closed before.
+                 */
+                Handle acquire();
+
+                /*! \brief Gets the number of open connections, in use or idle.
+                 *  \return The size of the pool.
+                 */
+                size_t size() const;
+
+        private:
+                /*! \brief Returns \p client to the pool, closed clients are discarded. */
+                void release(Client* client);
+
+                /*! \brief Creates a new connected client, nullptr if connecting failed. */
+                std::unique_ptr<Client> create() const;
+
+                /*! \brief Checks idle clients, closes old ones and opens new ones if needed. */
+                void maintain();
+
+                struct State;
+
+                const std::string address_;
+                const ClientPoolOptions options_;
+
+                /*! \brief Clients, locks and the background thread. */
+                std::unique_ptr<State> state_;
+        };
+
         /*! \brief Implementation for a distributed lock based on the Redlock algorithm.
          *
          *  \see https://redis.io/topics/distlock
@@ -0,0 +1,246 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#pragma once
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "resply.h"
+#include "resp-parser.h"
+
+
+/*! \brief Builds a Result tree from the elements reported by RespParser. */
+class ResultBuilder : public RespHandler {
+public:
+        ResultBuilder() : result_{&own_result_} { }
+
+        ResultBuilder(const ResultBuilder&) = delete;
+        ResultBuilder& operator=(const ResultBuilder&) = delete;
+
+        /*! \brief Returns the built result.
+         *  \return The result, complete once the parser is finished.
+         */
+        resply::Result& result() { return *result_; }
+
+        /*! \brief Prepares the builder for the next reply. */
+        void reset() { reset(own_result_); }
+
+        /*! \brief Prepares the builder for the next reply, which is built in place.
+         *  \param destination Where to build the result, e.g. an element of the final vector.
+         */
+        void reset(resply::Result& destination);
+
+        /*! \brief Replaces the result with an Type::IOError.
+         *  \param message The error message.
+         *  \param type Type::IOError or Type::Timeout.
+         */
+        void io_error(const std::string& message, resply::Result::Type type=resply::Result::Type::IOError);
+
+        void on_nil() override;
+        void on_integer(resply::Result::Type type, long long value) override;
+        void on_double(double value) override;
+        char* on_string(resply::Result::Type type, std::size_t length) override;
+        void on_aggregate(resply::Result::Type type, std::size_t count) override;
+        void on_aggregate_end() override;
+        void on_failure(const char* message) override;
+
+private:
+        /*! \brief Maximum number of elements to reserve memory for up front. */
+        const std::size_t MAX_RESERVED_ELEMENTS = 64 * 1024;
+
+        /*! \brief Returns the result for the next element. */
+        resply::Result& next();
+
+        /*! \brief The final (and intermediate) result. */
+        resply::Result* result_;
+
+        /*! \brief Holds the result unless it is built in place. */
+        resply::Result own_result_;
+
+        /*! \brief Aggregates which are currently being filled, innermost last.
+         *
+         *  Elements are only ever appended to the innermost aggregate, so
+         *  pointers to the outer ones stay valid while it is filled.
+         */
+        std::vector<resply::Result*> stack_;
+};
+
+
+/*! \brief Builds a ResultView tree in a ResultArena from the elements reported by RespParser. */
+class ViewBuilder : public RespHandler {
+public:
+        /*! \brief Constructs a new builder.
+         *  \param arena Arena to allocate strings and elements from.
+         */
+        explicit ViewBuilder(resply::ResultArena& arena) : arena_{arena}, result_{&own_result_} { }
+
+        ViewBuilder(const ViewBuilder&) = delete;
+        ViewBuilder& operator=(const ViewBuilder&) = delete;
+
+        /*! \brief Returns the built result.
+         *  \return The result, complete once the parser is finished.
+         */
+        resply::ResultView& result() { return *result_; }
+
+        /*! \brief Prepares the builder for the next reply. */
+        void reset() { reset(own_result_); }
+
+        /*! \brief Prepares the builder for the next reply, which is built in place.
+         *  \param destination Where to build the result, e.g. an element of the final vector.
+         */
+        void reset(resply::ResultView& destination);
+
+        /*! \brief Replaces the result with an Type::IOError.
+         *  \param message The error message.
+         *  \param type Type::IOError or Type::Timeout.
+         */
+        void io_error(const std::string& message, resply::Result::Type type=resply::Result::Type::IOError);
+
+        void on_nil() override;
+        void on_integer(resply::Result::Type type, long long value) override;
+        void on_double(double value) override;
+        char* on_string(resply::Result::Type type, std::size_t length) override;
+        void on_aggregate(resply::Result::Type type, std::size_t count) override;
+        void on_aggregate_end() override;
+        void on_failure(const char* message) override;
+
+protected:
+        /*! \brief Returns the view for the next element. */
+        resply::ResultView& next();
+
+        /*! \brief Called when the first \p count elements of an aggregate moved from \p from to \p to. */
+        virtual void on_elements_moved(const resply::ResultView*, std::size_t, resply::ResultView*) { }
+
+private:
+        /*! \brief An aggregate which is currently being filled. */
+        struct Frame {
+                /*! \brief The aggregate itself. */
+                resply::ResultView* aggregate;
+
+                /*! \brief Storage of the elements, of #capacity elements. */
+                resply::ResultView* elements;
+
+                /*! \brief Number of elements filled so far, announced in total and with storage. */
+                std::size_t filled, count, capacity;
+        };
+
+        /*! \brief Maximum number of elements to allocate memory for up front.
+         *
+         *  The announced size of an aggregate cannot be trusted until its elements
+         *  actually arrive, so larger aggregates grow their storage as needed.
+         */
+        const std::size_t MAX_RESERVED_ELEMENTS = 64 * 1024;
+
+        /*! \brief Sets #result_ to an error, copying \p message into the arena. */
+        void set_error(resply::Result::Type type, const char* message, std::size_t length);
+
+        /*! \brief Arena which holds the strings and elements. */
+        resply::ResultArena& arena_;
+
+        /*! \brief The final (and intermediate) result. */
+        resply::ResultView* result_;
+
+        /*! \brief Holds the result unless it is built in place. */
+        resply::ResultView own_result_;
+
+        /*! \brief Aggregates which are currently being filled, innermost last.
+         *
+         *  Elements are only ever appended to the innermost aggregate, so
+         *  pointers to the outer ones stay valid while it is filled.
+         */
+        std::vector<Frame> stack_;
+};
+
+
+/*! \brief Builds a ResultView tree whose strings reference the parsed data in place.
+ *
+ *  Only the elements of aggregates are allocated from the arena. As the
+ *  parsed data may still move while the reply is received, the strings are
+ *  only recorded as offsets until #resolve is called.
+ */
+class InPlaceViewBuilder : public ViewBuilder {
+public:
+        using ViewBuilder::ViewBuilder;
+
+        /*! \brief Prepares the builder for the next reply. */
+        void reset();
+
+        /*! \brief Replaces the result with an Type::IOError.
+         *  \param message The error message.
+         *  \param type Type::IOError or Type::Timeout.
+         */
+        void io_error(const std::string& message, resply::Result::Type type=resply::Result::Type::IOError);
+
+        /*! \brief Points all strings into the parsed data.
+         *  \param data The first byte which has been passed to the parser.
+         */
+        void resolve(const char* data);
+
+        void on_string_at(resply::Result::Type type, std::size_t offset, std::size_t length) override;
+        StringMode string_mode() const override { return StringMode::InPlace; }
+        void on_failure(const char* message) override;
+
+protected:
+        void on_elements_moved(const resply::ResultView* from, std::size_t count, resply::ResultView* to) override;
+
+private:
+        /*! \brief A string which still needs to be resolved. */
+        struct Unresolved {
+                resply::ResultView* view;
+                std::size_t offset;
+                std::size_t length;
+        };
+
+        /*! \brief Strings which still need to be resolved. */
+        std::vector<Unresolved> unresolved_;
+};
+
+
+/*! \brief Forwards the elements reported by RespParser to a resply::StreamHandler. */
+class StreamAdapter : public RespHandler {
+public:
+        /*! \brief Constructs a new adapter.
+         *  \param handler Handler to forward the elements to.
+         */
+        explicit StreamAdapter(resply::StreamHandler& handler) : handler_{handler}, depth_{}, push_{} { }
+
+        /*! \brief Prepares the adapter for the next reply. */
+        void reset();
+
+        /*! \brief Reports an Type::IOError to the handler.
+         *  \param message The error message.
+         *  \param type Type::IOError or Type::Timeout.
+         */
+        void io_error(const std::string& message, resply::Result::Type type=resply::Result::Type::IOError);
+
+        /*! \brief Indicates if the reply was an out-of-band push message.
+         *  \return If the reply was of Type::Push.
+         */
+        bool was_push() const { return push_; }
+
+        void on_nil() override;
+        void on_integer(resply::Result::Type type, long long value) override;
+        void on_double(double value) override;
+        char* on_string(resply::Result::Type type, std::size_t length) override;
+        void on_string_chunk(resply::Result::Type type, const char* data, std::size_t length, bool last) override;
+        StringMode string_mode() const override { return StringMode::Chunked; }
+        void on_aggregate(resply::Result::Type type, std::size_t count) override;
+        void on_aggregate_end() override;
+        void on_failure(const char* message) override;
+
+private:
+        /*! \brief Handler the elements are forwarded to. */
+        resply::StreamHandler& handler_;
+
+        /*! \brief Number of currently open aggregates. */
+        std::size_t depth_;
+
+        /*! \brief Indicates if the reply is a push message. */
+        bool push_;
+};
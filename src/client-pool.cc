@@ -0,0 +1,376 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "resply.h"
+
+
+namespace resply {
+
+struct ClientPool::State {
+        /*! \brief An idle client and since when it is idle. */
+        struct Idle {
+                std::unique_ptr<Client> client;
+                std::chrono::steady_clock::time_point since;
+        };
+
+        /*! \brief Holds a client parked for ClientPoolOptions::thread_affinity. */
+        struct Slot {
+                /*! \brief Parks \p client, unless the slot is taken.
+                 *  \return If \p client has been parked.
+                 */
+                bool park(Client* client)
+                {
+                        if (claimed.exchange(true, std::memory_order_acquire)) {
+                                return false;
+                        }
+
+                        since = std::chrono::steady_clock::now();
+                        parked.store(client, std::memory_order_release);
+
+                        return true;
+                }
+
+                /*! \brief Takes the parked client.
+                 *  \return The client and since when it is idle, no client if there is none.
+                 */
+                Idle take()
+                {
+                        Client* client{parked.exchange(nullptr, std::memory_order_acquire)};
+                        if (!client) {
+                                return {};
+                        }
+
+                        Idle idle{std::unique_ptr<Client>{client}, since};
+                        claimed.store(false, std::memory_order_release);
+
+                        return idle;
+                }
+
+                /*! \brief Set from parking a client until it is taken again, guards #since. */
+                std::atomic<bool> claimed{};
+                std::atomic<Client*> parked{};
+
+                /*! \brief When the parked client has been released. */
+                std::chrono::steady_clock::time_point since;
+        };
+
+        explicit State(size_t slot_count) : size{}, waiters{}, slots(slot_count), stopping{} { }
+
+        /*! \brief The slot of the calling thread in #slots. */
+        Slot& slot()
+        {
+                return slots[std::hash<std::thread::id>{}(std::this_thread::get_id()) % slots.size()];
+        }
+
+        /*! \brief Takes any client parked in #slots.
+         *  \return The client and since when it is idle, no client if there is none.
+         */
+        Idle take_parked()
+        {
+                for (Slot& slot: slots) {
+                        if (Idle idle{slot.take()}; idle.client) {
+                                return idle;
+                        }
+                }
+
+                return {};
+        }
+
+        /*! \brief Guards everything but #waiters and #slots. */
+        std::mutex mutex;
+
+        /*! \brief Signaled when a client is released or the pool shrinks. */
+        std::condition_variable available;
+
+        /*! \brief Idle clients, most recently released last. */
+        std::deque<Idle> idle;
+
+        /*! \brief Number of clients, including those in use, parked and being created. */
+        size_t size;
+
+        /*! \brief Number of threads waiting in ClientPool::acquire, clients are not parked then. */
+        std::atomic<size_t> waiters;
+
+        /*! \brief Released clients, parked per thread for ClientPoolOptions::thread_affinity. */
+        std::vector<Slot> slots;
+
+        /*! \brief Signaled when the pool is destroyed. */
+        std::condition_variable stopped;
+        bool stopping;
+
+        /*! \brief Runs ClientPool::maintain periodically. */
+        std::thread background;
+};
+
+
+ClientPool::ClientPool(const std::string& address, const ClientPoolOptions& options)
+        : address_{address}, options_{options},
+          state_{std::make_unique<State>(options.thread_affinity ? options.max_size : 0)}
+{
+        for (size_t i{}; i < options_.min_size; i++) {
+                if (std::unique_ptr<Client> client{create()}) {
+                        state_->idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+                        state_->size++;
+                }
+        }
+
+        std::chrono::milliseconds interval{options_.health_check_interval};
+        if (!interval.count() || (options_.idle_timeout.count() && options_.idle_timeout < interval)) {
+                interval = options_.idle_timeout;
+        }
+
+        if (interval.count()) {
+                state_->background = std::thread{[this, interval]() {
+                        std::unique_lock<std::mutex> lock{state_->mutex};
+
+                        while (!state_->stopped.wait_for(lock, interval, [this]() { return state_->stopping; })) {
+                                lock.unlock();
+                                maintain();
+                                lock.lock();
+                        }
+                }};
+        }
+}
+
+
+ClientPool::~ClientPool()
+{
+        {
+                std::lock_guard<std::mutex> lock{state_->mutex};
+                state_->stopping = true;
+        }
+
+        state_->stopped.notify_all();
+
+        if (state_->background.joinable()) {
+                state_->background.join();
+        }
+
+        while (state_->take_parked().client) {
+        }
+}
+
+
+ClientPool::Handle ClientPool::acquire()
+{
+        State& state{*state_};
+
+        if (options_.thread_affinity) {
+                if (State::Idle parked{state.slot().take()}; parked.client) {
+                        return Handle{this, parked.client.release()};
+                }
+        }
+
+        const auto deadline{std::chrono::steady_clock::now() + options_.wait_timeout};
+        std::unique_lock<std::mutex> lock{state.mutex};
+        bool timed_out{};
+
+        state.waiters++;
+
+        for (;;) {
+                if (!state.idle.empty()) {
+                        Client* client{state.idle.back().client.release()};
+                        state.idle.pop_back();
+                        state.waiters--;
+
+                        return Handle{this, client};
+                }
+
+                if (State::Idle parked{state.take_parked()}; parked.client) {
+                        state.waiters--;
+
+                        return Handle{this, parked.client.release()};
+                }
+
+                if (state.size < options_.max_size) {
+                        state.size++;
+                        state.waiters--;
+                        lock.unlock();
+
+                        std::unique_ptr<Client> client{create()};
+                        if (client) {
+                                return Handle{this, client.release()};
+                        }
+
+                        lock.lock();
+                        state.size--;
+                        state.available.notify_one();
+
+                        return Handle{};
+                }
+
+                if (timed_out) {
+                        state.waiters--;
+
+                        return Handle{};
+                }
+
+                timed_out = state.available.wait_until(lock, deadline) == std::cv_status::timeout;
+        }
+}
+
+
+size_t ClientPool::size() const
+{
+        std::lock_guard<std::mutex> lock{state_->mutex};
+
+        return state_->size;
+}
+
+
+void ClientPool::release(Client* released)
+{
+        State& state{*state_};
+        std::unique_ptr<Client> client{released};
+
+        if (!client->is_connected()) {
+                std::lock_guard<std::mutex> lock{state.mutex};
+                state.size--;
+                state.available.notify_one();
+
+                return;
+        }
+
+        if (options_.thread_affinity && !state.waiters) {
+                State::Slot& slot{state.slot()};
+
+                if (slot.park(client.get())) {
+                        client.release();
+
+                        if (!state.waiters) {
+                                return;
+                        }
+
+                        // A thread started waiting meanwhile, which might have missed the slot.
+                        client = slot.take().client;
+                        if (!client) {
+                                return;
+                        }
+                }
+        }
+
+        std::lock_guard<std::mutex> lock{state.mutex};
+        state.idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+        state.available.notify_one();
+}
+
+
+std::unique_ptr<Client> ClientPool::create() const
+{
+        auto client{std::make_unique<Client>(address_)};
+        client->connect();
+
+        return client->is_connected() ? std::move(client) : nullptr;
+}
+
+
+void ClientPool::maintain()
+{
+        State& state{*state_};
+        const auto now{std::chrono::steady_clock::now()};
+
+        std::vector<State::Idle> closing, checking;
+
+        {
+                std::lock_guard<std::mutex> lock{state.mutex};
+
+                // Parked clients are idle as well, since they were released.
+                for (State::Idle parked{state.take_parked()}; parked.client; parked = state.take_parked()) {
+                        auto position{std::upper_bound(state.idle.begin(), state.idle.end(), parked.since,
+                                [](auto since, const State::Idle& idle) { return since < idle.since; })};
+
+                        state.idle.insert(position, std::move(parked));
+                }
+
+                while (options_.idle_timeout.count() && !state.idle.empty() && state.size > options_.min_size &&
+                       now - state.idle.front().since >= options_.idle_timeout) {
+                        closing.push_back(std::move(state.idle.front()));
+                        state.idle.pop_front();
+                        state.size--;
+                }
+
+                // Recently used clients are known to be healthy.
+                while (options_.health_check_interval.count() && !state.idle.empty() &&
+                       now - state.idle.front().since >= options_.health_check_interval) {
+                        checking.push_back(std::move(state.idle.front()));
+                        state.idle.pop_front();
+                }
+        }
+
+        closing.clear();
+
+        std::vector<State::Idle> healthy;
+        for (State::Idle& idle: checking) {
+                // A stalled connection must not hold up the checks of all others.
+                const std::chrono::milliseconds command_timeout{idle.client->command_timeout()};
+                idle.client->command_timeout(command_timeout.count()
+                                             ? std::min(command_timeout, options_.health_check_interval)
+                                             : options_.health_check_interval);
+
+                const Result reply{idle.client->command("ping")};
+                idle.client->command_timeout(command_timeout);
+
+                if (reply.type() == Result::Type::String && reply.string() == "PONG") {
+                        healthy.push_back(std::move(idle));
+                }
+        }
+
+        size_t missing{};
+
+        {
+                std::lock_guard<std::mutex> lock{state.mutex};
+
+                // Still the ones idle for the longest time.
+                for (auto idle{healthy.rbegin()}; idle != healthy.rend(); ++idle) {
+                        state.idle.push_front(std::move(*idle));
+                }
+
+                state.size -= checking.size() - healthy.size();
+
+                if (state.size < options_.min_size) {
+                        missing = options_.min_size - state.size;
+                        state.size += missing;
+                }
+        }
+
+        state.available.notify_all();
+        checking.clear();
+
+        for (; missing; missing--) {
+                std::unique_ptr<Client> client{create()};
+                std::lock_guard<std::mutex> lock{state.mutex};
+
+                if (client) {
+                        state.idle.push_back({std::move(client), std::chrono::steady_clock::now()});
+                } else {
+                        state.size--;
+                }
+
+                state.available.notify_one();
+        }
+}
+
+
+void ClientPool::Handle::reset()
+{
+        if (client_) {
+                pool_->release(client_);
+                client_ = nullptr;
+        }
+}
+
+}
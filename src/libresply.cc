@@ -10,18 +10,24 @@
 #include <cctype>
 #include <algorithm>
 #include <iostream>
-#include <numeric>
 #include <unordered_map>
 #include <cctype>
 #include <fstream>
 #include <array>
 #include <chrono>
 #include <thread>
+#include <deque>
+#include <optional>
+#include <mutex>
+#include <atomic>
+#include <future>
 
 #include <asio.hpp>
 
 #include "resply.h"
 #include "resp-parser.h"
+#include "receive-buffer.h"
+#include "result-builder.h"
 
 
 namespace {
@@ -35,6 +41,102 @@ bool check_asio_error(asio::error_code& error_code)
         return !!error_code;
 }
 
+/*! \brief The type of the result reporting \p error_code. */
+resply::Result::Type failure_type(const asio::error_code& error_code)
+{
+        return error_code == asio::error::timed_out ? resply::Result::Type::Timeout : resply::Result::Type::IOError;
+}
+
+/*! \brief Checks if \p type indicates that the reply, and any following it, could not be received. */
+bool is_failure(resply::Result::Type type)
+{
+        return type == resply::Result::Type::IOError || type == resply::Result::Type::Timeout;
+}
+
+/*! \brief The number of bytes transferred by an asynchronous operation. */
+size_t transferred(size_t count)
+{
+        return count;
+}
+
+/*! \brief Operations like connecting transfer nothing. */
+template <typename T>
+size_t transferred(const T&)
+{
+        return 0;
+}
+
+/*! \brief Checks if the name of the serialized \p command ends in "subscribe", case-insensitively.
+ *
+ *  This matches all of (P|S)(UN)SUBSCRIBE, which are not allowed in pipelines.
+ */
+bool is_subscribe_command(const std::string& command)
+{
+        // Skip the array header and the length of the name, e.g. "*2\r\n$9\r\n".
+        const size_t size_end{command.find('\n', command.find('\n') + 1)};
+        const size_t name_end{command.find('\r', size_end)};
+
+        if (size_end == std::string::npos || name_end == std::string::npos) {
+                return false;
+        }
+
+        const std::string_view name{command.data() + size_end + 1, name_end - size_end - 1};
+        const std::string_view suffix{"subscribe"};
+
+        return name.size() >= suffix.size() &&
+               std::equal(suffix.cbegin(), suffix.cend(), name.cend() - suffix.size(), [](char a, char b) {
+                       return a == std::tolower(static_cast<unsigned char>(b));
+               });
+}
+
+const resply::Result& to_owned(const resply::Result& result)
+{
+        return result;
+}
+
+resply::Result to_owned(const resply::ResultView& result)
+{
+        return result.to_owned();
+}
+
+resply::Result::Type type_of(const resply::Result& result)
+{
+        return result.type();
+}
+
+resply::Result::Type type_of(const resply::ResultView& result)
+{
+        return result.type;
+}
+
+void print_aggregate(std::ostream& ostream, const resply::Result& result, size_t indent)
+{
+        const bool is_map{result.type() == resply::Result::Type::Map};
+        const size_t step{is_map ? 2u : 1u};
+
+        for (size_t i{}; i + step <= result.array().size(); i += step) {
+                const std::string prefix{std::to_string(i / step + 1) + (is_map ? "# " : ") ")};
+                const resply::Result& element{result.array()[i + step - 1]};
+
+                if (i) {
+                        ostream << '\n' << std::string(indent, ' ');
+                }
+
+                ostream << prefix;
+
+                if (is_map) {
+                        ostream << result.array()[i] << " => ";
+                }
+
+                // Nested aggregates are aligned to their index, like redis-cli does.
+                if (element.is_aggregate()) {
+                        print_aggregate(ostream, element, indent + prefix.length());
+                } else {
+                        ostream << element;
+                }
+        }
+}
+
 long get_system_clock_ms()
 {
         namespace chrono = std::chrono;
@@ -60,18 +162,31 @@ const std::string& version()
 
 std::ostream& operator<<(std::ostream& ostream, const Result& result)
 {
-        switch (result.type) {
+        switch (result.type()) {
         case Result::Type::ProtocolError:
         case Result::Type::IOError:
+        case Result::Type::Timeout:
                 ostream << "(error) ";
                 [[fallthrough]];
 
         case Result::Type::String:
-                ostream << '"' << result.string << '"';
+                ostream << '"' << result.string() << '"';
                 break;
 
         case Result::Type::Integer:
-                ostream << result.integer;
+                ostream << result.integer();
+                break;
+
+        case Result::Type::BigNumber:
+                ostream << result.string();
+                break;
+
+        case Result::Type::Double:
+                ostream << result.floating();
+                break;
+
+        case Result::Type::Boolean:
+                ostream << (result.integer() ? "(true)" : "(false)");
                 break;
 
         case Result::Type::Nil:
@@ -79,14 +194,10 @@ std::ostream& operator<<(std::ostream& ostream, const Result& result)
                 break;
 
         case Result::Type::Array:
-                for (size_t i{}; i < result.array.size(); i++) {
-                        ostream << i+1 << ") " << result.array[i];
-
-                        if (i < result.array.size()-1) {
-                                ostream << '\n';
-                        }
-                }
-
+        case Result::Type::Map:
+        case Result::Type::Set:
+        case Result::Type::Push:
+                print_aggregate(ostream, result, 0);
                 break;
         }
 
@@ -94,20 +205,137 @@ std::ostream& operator<<(std::ostream& ostream, const Result& result)
 }
 
 
+Result::Result(Type type, std::string string) : string{type, std::move(string)} { }
+Result::Result(Type type, std::vector<Result> array) : array{type, std::move(array)} { }
+Result::Result(const Result& other) : integer{Type::Nil, 0} { copy_from(other); }
+Result::Result(Result&& other) noexcept : integer{Type::Nil, 0} { move_from(std::move(other)); }
+Result::~Result() { destroy(); }
+
+Result& Result::operator=(const Result& other)
+{
+        return *this = Result{other};
+}
+
+Result& Result::operator=(Result&& other) noexcept
+{
+        if (this != &other) {
+                destroy();
+                move_from(std::move(other));
+        }
+
+        return *this;
+}
+
+void Result::reset(Type type)
+{
+        destroy();
+        construct(type);
+}
+
+bool Result::is_string() const
+{
+        return holds(type, static_cast<const std::string*>(nullptr));
+}
+
+bool Result::is_aggregate() const
+{
+        return holds(type, static_cast<const std::vector<Result>*>(nullptr));
+}
+
+bool Result::holds(Type type, const std::string*)
+{
+        return type == Type::String || type == Type::ProtocolError ||
+               type == Type::IOError || type == Type::Timeout || type == Type::BigNumber;
+}
+
+bool Result::holds(Type type, const long long*)
+{
+        return type == Type::Integer || type == Type::Boolean;
+}
+
+bool Result::holds(Type type, const double*)
+{
+        return type == Type::Double;
+}
+
+bool Result::holds(Type type, const std::vector<Result>*)
+{
+        return type == Type::Array || type == Type::Map || type == Type::Set || type == Type::Push;
+}
+
+void Result::construct(Type type)
+{
+        if (holds(type, static_cast<const std::string*>(nullptr))) {
+                new (&string) Field<std::string>{type, {}};
+        } else if (holds(type, static_cast<const std::vector<Result>*>(nullptr))) {
+                new (&array) Field<std::vector<Result>>{type, {}};
+        } else if (type == Type::Double) {
+                new (&floating) Field<double>{type, 0.0};
+        } else {
+                // Also the field of Type::Nil, which holds no value.
+                new (&integer) Field<long long>{type, 0};
+        }
+}
+
+void Result::destroy()
+{
+        if (is_string()) {
+                string.~Field();
+        } else if (is_aggregate()) {
+                array.~Field();
+        }
+}
+
+void Result::copy_from(const Result& other)
+{
+        if (other.is_string()) {
+                new (&string) Field<std::string>{other.type, other.string.value_};
+        } else if (other.is_aggregate()) {
+                new (&array) Field<std::vector<Result>>{other.type, other.array.value_};
+        } else if (other.type == Type::Double) {
+                new (&floating) Field<double>{other.type, other.floating.value_};
+        } else {
+                new (&integer) Field<long long>{other.type, other.integer.value_};
+        }
+}
+
+void Result::move_from(Result&& other)
+{
+        if (other.is_string()) {
+                new (&string) Field<std::string>{other.type, std::move(other.string.value_)};
+        } else if (other.is_aggregate()) {
+                new (&array) Field<std::vector<Result>>{other.type, std::move(other.array.value_)};
+        } else if (other.type == Type::Double) {
+                new (&floating) Field<double>{other.type, other.floating.value_};
+        } else {
+                new (&integer) Field<long long>{other.type, other.integer.value_};
+        }
+}
+
+
 class ClientImpl {
 public:
         friend class Client;
 
-        ClientImpl(const std::string& host, const std::string& port, size_t timeout)
-                : host_{host}, port_{port}, timeout_{timeout}, socket_{io_context_}
+        /*! \param io_context Context to run on, or nullptr to use an own one. */
+        ClientImpl(asio::io_context* io_context, const std::string& host, const std::string& port, size_t timeout)
+                : host_{host}, port_{port}, timeout_{timeout},
+                  io_context_{io_context ? *io_context : own_io_context_.emplace()},
+                  strand_{io_context_.get_executor()}, socket_{io_context_}, protocol_version_{2},
+                  command_timeout_{}, deadline_{std::chrono::steady_clock::time_point::max()},
+                  submissions_{}, async_parser_{async_builder_}, reading_{}, writing_{}
         {
-                (void)timeout_;
         }
 
 
         ~ClientImpl()
         {
                 close();
+
+                for (Submission* submission{submissions_.load()}; submission;) {
+                        std::unique_ptr<Submission> current{submission};
+                        submission = submission->next;
+                }
         }
 
 
@@ -115,214 +343,1415 @@ public:
         {
                 asio::error_code error_code;
 
-                asio::ip::tcp::resolver resolver{io_context_};
-                auto results{resolver.resolve(host_, port_, error_code)};
-                check_asio_error(error_code);
+                // Includes the protocol negotiation, but not resolving the address.
+                begin(std::chrono::milliseconds{timeout_});
 
-                asio::connect(socket_, results, error_code);
-                check_asio_error(error_code);
+                // Braces would pick the initializer list constructor, as an endpoint converts from anything.
+                const auto endpoints = resolve(error_code);
+
+                if (error_code) {
+                        // Reported below.
+                } else if (deadline_ == std::chrono::steady_clock::time_point::max()) {
+                        asio::connect(socket_, endpoints, error_code);
+                } else if (own_io_context_) {
+                        error_code = complete([this, &endpoints](auto handler) {
+                                asio::async_connect(socket_, endpoints, handler);
+                        }).first;
+                } else {
+                        error_code = connect_detached(endpoints);
+                }
+
+                if (check_asio_error(error_code)) {
+                        // Leaves the client unconnected, instead of an open, but unusable socket.
+                        socket_.close();
+                        return;
+                }
+
+                buffer_.clear();
+
+                if (!own_io_context_) {
+                        // Like any other synchronous command, see Client::Client(asio::io_context&, ...).
+                        begin(command_timeout_);
+                }
+
+                if (protocol_version_ != 2) {
+                        negotiate_protocol();
+                }
         }
 
 
         void close()
         {
                 socket_.close();
+                buffer_.clear();
         }
 
 
-        Result send(const std::string& command)
+        Result send(const SerializedCommand& command)
         {
-                asio::error_code error_code;
-
-                asio::write(socket_, asio::buffer(command), error_code);
-                check_asio_error(error_code);
+                begin(command_timeout_);
+                write(command);
 
                 return in_subscribed_mode() ? Result{} : receive_response();
         }
 
-        std::vector<Result> send_batch(const std::vector<std::string>& commands)
+        ResultView send(const SerializedCommand& command, ResultArena& arena)
         {
-                asio::error_code error_code;
-                const std::string raw_commands{
-                        std::accumulate(commands.cbegin(), commands.cend(), std::string{})
-                };
+                begin(command_timeout_);
+                write(command);
 
-                asio::write(socket_, asio::buffer(raw_commands), error_code);
-                check_asio_error(error_code);
+                if (in_subscribed_mode()) {
+                        return ResultView{};
+                }
 
-                return receive_responses(commands.size());
+                ViewBuilder builder{arena};
+                return receive_responses(1, builder).front();
         }
 
-        void listen_for_messages(ChannelCallback other)
+        ResultView send_view(const SerializedCommand& command)
         {
+                begin(command_timeout_);
+                write(command);
+
+                if (in_subscribed_mode()) {
+                        return ResultView{};
+                }
+
+                view_arena_.reset();
+                InPlaceViewBuilder builder{view_arena_};
+                RespParser parser{builder};
+
                 for (;;) {
-                        Result result{receive_response()};
+                        builder.reset();
 
-                        if (result.type == Result::Type::Array && result.array.size() == 3 &&
-                            result.array.front().type == Result::Type::String && result.array.front().string == "message") {
-                                std::string& channel = result.array[1].string;
-                                std::string& message = result.array[2].string;
+                        // Keeps the reply in place until the next command, see #write.
+                        buffer_.pin();
+                        receive_result(parser, builder);
+                        builder.resolve(buffer_.pinned_data());
 
-                                if (channel_callbacks_.count(channel)) {
-                                        channel_callbacks_[channel](channel, message);
-                                } else {
-                                        other(channel, message);
-                                }
+                        if (builder.result().type != Result::Type::Push) {
+                                return builder.result();
                         }
+
+                        dispatch_message(builder.result().to_owned(), [](auto, auto) {});
                 }
         }
 
-        std::unordered_map<std::string, ChannelCallback>& channel_callbacks()
+        void send_stream(const SerializedCommand& command, StreamHandler& handler)
         {
-                return channel_callbacks_;
-        }
+                begin(command_timeout_);
+                write(command);
 
-        const std::string& host() const
-        {
-                return host_;
+                if (in_subscribed_mode()) {
+                        return;
+                }
+
+                StreamAdapter adapter{handler};
+                RespParser parser{adapter};
+
+                do {
+                        adapter.reset();
+                        receive_result(parser, adapter);
+                } while (adapter.was_push());
         }
 
-        const std::string& port() const
+        /*! \brief Sends \p command and streams its reply to \p handler,
+         *         push messages are delivered to their callbacks instead.
+         */
+        void send_decoded(const SerializedCommand& command, StreamHandler& handler)
         {
-                return port_;
+                begin(command_timeout_);
+                write(command);
+                receive_decoded(1, handler);
         }
 
-        bool is_connected() const
+        /*! \brief Sends \p num serialized \p commands and streams their replies to \p handler,
+         *         push messages are delivered to their callbacks instead.
+         *  \param timeout Deadline of the whole batch, zero for #command_timeout_.
+         */
+        void send_decoded(const std::string& commands, size_t num, StreamHandler& handler,
+                          std::chrono::milliseconds timeout)
         {
-                return socket_.is_open();
+                begin(timeout.count() ? timeout : command_timeout_);
+                write(commands);
+                receive_decoded(num, handler);
         }
 
-        bool in_subscribed_mode() const
+        /*! \brief Sends \p num serialized \p commands at once and receives their replies.
+         *  \param timeout Deadline of the whole batch, zero for #command_timeout_.
+         */
+        std::vector<Result> send_batch(const std::string& commands, size_t num, std::chrono::milliseconds timeout)
         {
-                return channel_callbacks_.size();
+                begin(timeout.count() ? timeout : command_timeout_);
+                write(commands);
+
+                ResultBuilder builder;
+                return receive_responses(num, builder);
         }
 
-private:
-        Result receive_response()
+        /*! \brief Sends \p num serialized \p commands at once and receives their replies into \p arena.
+         *  \param timeout Deadline of the whole batch, zero for #command_timeout_.
+         */
+        std::vector<ResultView> send_batch(const std::string& commands, size_t num, ResultArena& arena,
+                                           std::chrono::milliseconds timeout)
         {
-                return receive_responses(1).front();
+                begin(timeout.count() ? timeout : command_timeout_);
+                write(commands);
+
+                ViewBuilder builder{arena};
+                return receive_responses(num, builder);
         }
 
-        std::vector<Result> receive_responses(size_t num)
+        /*! \brief Sends serialized \p commands without waiting for replies, calling \p drain after each chunk.
+         *
+         *  \p drain must read the replies which arrived meanwhile. Otherwise, a large
+         *  batch could fill the socket buffers in both directions, and both sides
+         *  would wait for the other one to read.
+         */
+        void send_only(const std::string& commands, const std::function<void()>& drain)
         {
-                asio::error_code error_code;
-                asio::streambuf buffer;
-                std::vector<Result> results;
+                // Invalidates the views returned by #send_view.
+                buffer_.unpin();
 
-                for (size_t i{}; i < num; i++) {
-                        RespParser parser;
-                        bool cont{false};
+                for (size_t position{}; position < commands.size(); position += SEND_CHUNK_SIZE) {
+                        begin(command_timeout_);
+                        write_all(asio::buffer(commands.data() + position,
+                                               std::min(SEND_CHUNK_SIZE, commands.size() - position)));
 
-                        do {
-                                if (!buffer.size()) {
-                                        asio::read_until(socket_, buffer, '\n');
-                                        check_asio_error(error_code);
-                                }
-                                std::istream stream{&buffer};
-                                cont = parser.parse(stream);
-                        } while (cont);
+                        if (failure_) {
+                                return;
+                        }
 
-                        results.push_back(parser.result());
+                        drain();
                 }
-
-                return results;
         }
 
-        const std::string host_;
-        const std::string port_;
-        const size_t timeout_;
+        /*! \brief Number of bytes #send_only writes between draining replies. */
+        static constexpr size_t SEND_CHUNK_SIZE = 16 * 1024;
+
+        /*! \brief Passes up to \p max replies to \p callback.
+         *  \param min Number of replies to wait for.
+         *  \return The number of replies passed on.
+         *
+         *  Beyond \p min, replies are only received as long as data is
+         *  available without waiting. Waits at most #command_timeout_ for all of them.
+         */
+        size_t receive_available(size_t min, size_t max, const ReplyCallback& callback)
+        {
+                begin(command_timeout_);
 
-        asio::io_context io_context_;
-        asio::ip::tcp::socket socket_;
+                ResultBuilder builder;
+                RespParser parser{builder};
+                size_t received{};
 
-        std::unordered_map<std::string, ChannelCallback> channel_callbacks_;
+                while (received < max && (received < min || is_readable())) {
+                        builder.reset();
+                        receive_result(parser, builder);
 
-};
+                        const Result& result{builder.result()};
 
+                        if (result.type() == Result::Type::Push) {
+                                dispatch_message(result, [](auto, auto) {});
+                        } else if (is_failure(result.type())) {
+                                // None of the remaining replies will arrive.
+                                for (; received < max; received++) {
+                                        callback(result);
+                                }
+                        } else {
+                                callback(result);
+                                received++;
+                        }
+                }
 
-Client::Client() : Client{"localhost", "6379"} { }
+                return received;
+        }
 
+        /*! \brief Sends \p command asynchronously, \p callback receives its reply on #strand_. */
+        void send_async(const SerializedCommand& command, ReplyCallback callback, const AsyncOptions& options)
+        {
+                // Referenced arguments need not outlive this call, so copy everything.
+                std::string data;
+                command.append_to(data);
 
-Client::Client(const std::string& address, size_t timeout)
-{
-        std::string host, port;
-        std::stringstream sstream{address};
+                send_async(std::move(data), 1, std::move(callback), options);
+        }
 
-        std::getline(sstream, host, ':');
-        std::getline(sstream, port);
+        /*! \brief Sends \p num serialized \p commands asynchronously, \p callback receives each reply.
+         *
+         *  Safe to call from any thread, see #submissions_.
+         */
+        void send_async(std::string commands, size_t num, ReplyCallback callback, const AsyncOptions& options)
+        {
+                auto submission{new Submission{std::make_shared<AsyncRequest>(), std::move(commands), options, nullptr}};
+                submission->request->callback = std::move(callback);
+                submission->request->outstanding = submission->request->undelivered = num;
 
-        impl_ = std::make_unique<ClientImpl>(host, port, timeout);
-}
+                if (!options.deadline.count()) {
+                        submission->options.deadline = command_timeout_;
+                }
 
+                Submission* head{submissions_.load(std::memory_order_relaxed)};
+                do {
+                        submission->next = head;
+                } while (!submissions_.compare_exchange_weak(head, submission, std::memory_order_release,
+                                                             std::memory_order_relaxed));
 
-Client::Client(const std::string& host, const std::string& port, size_t timeout)
-        : impl_{std::make_unique<ClientImpl>(host, port, timeout)}
-{
-}
+                // Only the first submission since the last drain needs to wake up the I/O loop.
+                if (!head) {
+                        asio::post(strand_, [this]() { drain_submissions(); });
+                }
+        }
 
+        /*! \brief Fails all asynchronous commands submitted so far with an I/O error.
+         *
+         *  Lets #io_context_ run out of work, even if the server never replies.
+         */
+        void abort_async()
+        {
+                asio::post(strand_, [this]() {
+                        if (!pending_.empty()) {
+                                fail_async(asio::error::operation_aborted);
+                        }
+                });
+        }
 
-Client::~Client() { }
+        /*! \brief Runs #io_context_ until all asynchronous commands are finished. */
+        void run()
+        {
+                io_context_.restart();
+                io_context_.run();
+        }
 
+        void listen_for_messages(ChannelCallback other)
+        {
+                // Messages may take arbitrarily long to arrive.
+                begin(std::chrono::milliseconds{});
 
-void Client::connect() { impl_->connect(); }
-void Client::close() { impl_->close(); }
-const std::string& Client::host() const { return impl_->host(); }
-const std::string& Client::port() const { return impl_->port(); }
-bool Client::is_connected() const { return impl_->is_connected(); }
+                ResultBuilder builder;
+                RespParser parser{builder};
 
-bool Client::in_subscribed_mode() const
-{
-        return impl_->in_subscribed_mode();
-}
+                for (;;) {
+                        builder.reset();
+                        receive_result(parser, builder);
 
-Client& Client::subscribe(const std::string& channel, ChannelCallback callback)
-{
-        impl_->channel_callbacks()[channel] = callback;
-        command("subscribe", channel);
+                        if (is_failure(builder.result().type())) {
+                                break;
+                        }
 
-        return *this;
-}
+                        dispatch_message(builder.result(), other);
+                }
+        }
 
-Client& Client::psubscribe(const std::string& pattern, ChannelCallback callback)
-{
-        impl_->channel_callbacks()[pattern] = callback;
-        command("psubscribe", pattern);
+        int protocol_version() const
+        {
+                return protocol_version_;
+        }
 
-        return *this;
-}
+        void protocol_version(int version)
+        {
+                protocol_version_ = version;
 
-Result Client::finish_command(const std::string& command)
-{
-        return command.empty() ? Result{} : impl_->send(command);
-}
+                if (is_connected()) {
+                        begin(command_timeout_);
+                        negotiate_protocol();
+                }
+        }
 
-void Client::listen_for_messages(ChannelCallback other)
-{
-        impl_->listen_for_messages(other);
-}
+        std::chrono::milliseconds command_timeout() const
+        {
+                return command_timeout_;
+        }
 
-std::vector<Result> Client::Pipeline::send()
-{
-        if (commands_.empty()) {
-                return {};
+        void command_timeout(std::chrono::milliseconds timeout)
+        {
+                command_timeout_ = timeout;
         }
 
-        auto results = client_.impl_->send_batch(commands_);
+        void push_callback(PushCallback callback)
+        {
+                push_callback_ = callback;
+        }
 
-        commands_.clear();
-        return results;
-}
+        std::unordered_map<std::string, ChannelCallback>& channel_callbacks()
+        {
+                return channel_callbacks_;
+        }
 
-Client::Pipeline& Client::Pipeline::finish_command(const std::string& command)
-{
-        std::string lower;
-        std::transform(command.begin(), command.end(), lower.begin(), ::tolower);
+        const std::string& host() const
+        {
+                return host_;
+        }
 
-        if (!command.empty() && lower.find("subscribe") == std::string::npos) {
-                commands_.emplace_back(command + "\r\n");
+        const std::string& port() const
+        {
+                return port_;
         }
 
-        return *this;
+        bool is_connected() const
+        {
+                return socket_.is_open();
+        }
+
+        bool in_subscribed_mode() const
+        {
+                return channel_callbacks_.size();
+        }
+
+private:
+        /*! \brief One or more asynchronous commands sent at once, waiting for their replies. */
+        struct AsyncRequest {
+                /*! \brief Receives each reply, in order. */
+                ReplyCallback callback;
+
+                /*! \brief Number of replies which have not arrived yet. */
+                size_t outstanding;
+
+                /*! \brief Number of replies not yet passed to #callback, less than
+                 *         #outstanding after the request finished early.
+                 */
+                size_t undelivered;
+
+                /*! \brief Expires at the deadline, if any. */
+                std::unique_ptr<asio::steady_timer> timer;
+
+                /*! \brief Signal which cancels this request, if any. */
+                std::shared_ptr<CancellationSignal> cancellation;
+
+                /*! \brief Id of the handler registered with #cancellation. */
+                size_t cancellation_id;
+        };
+
+        /*! \brief An asynchronous request, as submitted by any thread. */
+        struct Submission {
+                std::shared_ptr<AsyncRequest> request;
+
+                /*! \brief The serialized commands of #request. */
+                std::string commands;
+
+                AsyncOptions options;
+
+                /*! \brief The previously submitted request. */
+                Submission* next;
+        };
+
+        /*! \brief Resolves the address of the server, which is a unix domain socket if #port_ is empty. */
+        std::vector<asio::generic::stream_protocol::endpoint> resolve(asio::error_code& error_code)
+        {
+                std::vector<asio::generic::stream_protocol::endpoint> endpoints;
+
+                if (port_.empty()) {
+#if defined(ASIO_HAS_LOCAL_SOCKETS)
+                        endpoints.emplace_back(asio::local::stream_protocol::endpoint{host_});
+#else
+                        error_code = asio::error::operation_not_supported;
+#endif
+                        return endpoints;
+                }
+
+                asio::ip::tcp::resolver resolver{io_context_};
+                for (const auto& result: resolver.resolve(host_, port_, error_code)) {
+                        endpoints.emplace_back(result.endpoint());
+                }
+
+                return endpoints;
+        }
+
+        /*! \brief Checks if received data is available without waiting. */
+        bool is_readable()
+        {
+                asio::error_code error_code;
+
+                return !buffer_.empty() || socket_.available(error_code) > 0;
+        }
+
+        void write(const std::string& command)
+        {
+                // Invalidates the views returned by #send_view.
+                buffer_.unpin();
+
+                write_all(asio::buffer(command));
+        }
+
+        /*! \brief Writes \p command, sending referenced arguments straight from their memory. */
+        void write(const SerializedCommand& command)
+        {
+                if (command.references().empty()) {
+                        write(command.data());
+                        return;
+                }
+
+                buffer_.unpin();
+
+                const std::string& data{command.data()};
+                std::vector<asio::const_buffer> buffers;
+                buffers.reserve(command.references().size() * 2 + 1);
+
+                size_t position{};
+                for (const SerializedCommand::Reference& reference: command.references()) {
+                        buffers.emplace_back(data.data() + position, reference.offset - position);
+                        buffers.emplace_back(reference.data.data(), reference.data.size());
+                        position = reference.offset;
+                }
+                buffers.emplace_back(data.data() + position, data.size() - position);
+
+                write_all(buffers);
+        }
+
+        /*! \brief Starts a synchronous operation, which has to finish within \p timeout.
+         *  \param timeout The time for all reads and writes of the operation, zero for none.
+         */
+        void begin(std::chrono::milliseconds timeout)
+        {
+                deadline_ = timeout.count() ? std::chrono::steady_clock::now() + timeout
+                                            : std::chrono::steady_clock::time_point::max();
+                failure_.clear();
+        }
+
+        /*! \brief Writes all of \p buffers, within #deadline_.
+         *
+         *  Nothing is written after an error, which is kept in #failure_.
+         */
+        template <typename ConstBufferSequence>
+        void write_all(const ConstBufferSequence& buffers)
+        {
+                if (failure_) {
+                        return;
+                }
+
+                asio::error_code error_code;
+
+                if (deadline_ == std::chrono::steady_clock::time_point::max()) {
+                        asio::write(socket_, buffers, error_code);
+                } else {
+                        error_code = complete([this, &buffers](auto handler) {
+                                asio::async_write(socket_, buffers, handler);
+                        }).first;
+                }
+
+                if (error_code) {
+                        fail(error_code);
+                }
+        }
+
+        /*! \brief Reads some data into \p buffer, within #deadline_.
+         *  \return The number of bytes read.
+         *
+         *  Nothing is read after an error, which is kept in #failure_.
+         */
+        size_t read_some(asio::mutable_buffer buffer)
+        {
+                if (failure_) {
+                        return 0;
+                }
+
+                asio::error_code error_code;
+                size_t count;
+
+                if (deadline_ == std::chrono::steady_clock::time_point::max()) {
+                        count = socket_.read_some(buffer, error_code);
+                } else {
+                        std::tie(error_code, count) = complete([this, buffer](auto handler) {
+                                socket_.async_read_some(buffer, handler);
+                        });
+                }
+
+                if (error_code) {
+                        fail(error_code);
+                }
+
+                return count;
+        }
+
+        /*! \brief Runs an asynchronous operation until it completes or #deadline_ passes.
+         *  \param initiate Starts the operation, given its completion handler.
+         *  \return The error of the operation, or asio::error::timed_out, and the bytes transferred.
+         *
+         *  On a timeout, the connection is closed, as the operation might still complete
+         *  later. E.g. a reply arriving late would be taken as the reply of the next command.
+         *
+         *  A shared #io_context_ must be run by another thread, a handler running on it
+         *  would wait for itself. The operation then fails right away with
+         *  asio::error::operation_not_supported, without touching the connection.
+         */
+        template <typename Initiate>
+        std::pair<asio::error_code, size_t> complete(Initiate initiate)
+        {
+                if (!own_io_context_ && io_context_.get_executor().running_in_this_thread()) {
+                        return {asio::error::operation_not_supported, 0};
+                }
+
+                auto promise{std::make_shared<std::promise<std::pair<asio::error_code, size_t>>>()};
+                auto result{promise->get_future()};
+
+                initiate([promise](const asio::error_code& error_code, const auto& value) {
+                        promise->set_value({error_code, transferred(value)});
+                });
+
+                if (own_io_context_) {
+                        io_context_.restart();
+
+                        // Only until the operation completes, other work (e.g. asynchronous commands) may be pending.
+                        while (result.wait_for(std::chrono::seconds{0}) != std::future_status::ready &&
+                               io_context_.run_one_until(deadline_)) {
+                        }
+                }
+
+                // Otherwise, #io_context_ is run by other threads.
+                if (result.wait_until(deadline_) == std::future_status::ready) {
+                        return result.get();
+                }
+
+                // Aborts the operation, its handler only keeps the promise alive.
+                asio::error_code ignored;
+                socket_.close(ignored);
+
+                return {asio::error::timed_out, 0};
+        }
+
+        /*! \brief Connects to the first reachable of \p endpoints within #deadline_, without running #io_context_.
+         *  \return The error of the last attempt, or asio::error::timed_out.
+         *
+         *  A shared #io_context_ is usually only run after connecting, so waiting
+         *  for it to complete the connect would always run into the timeout.
+         *  The socket is connected on a context of its own instead and then handed over.
+         */
+        asio::error_code connect_detached(const std::vector<asio::generic::stream_protocol::endpoint>& endpoints)
+        {
+                using Endpoint = asio::generic::stream_protocol::endpoint;
+
+                asio::io_context io_context;
+                asio::generic::stream_protocol::socket socket{io_context};
+                std::optional<std::pair<asio::error_code, Endpoint>> result;
+
+                asio::async_connect(socket, endpoints, [&result](const asio::error_code& error_code, const Endpoint& endpoint) {
+                        result.emplace(error_code, endpoint);
+                });
+
+                io_context.run_until(deadline_);
+
+                if (!result) {
+                        // Aborts the connect, so that its handler does not outlive this frame.
+                        socket.close();
+                        io_context.run();
+
+                        return asio::error::timed_out;
+                }
+
+                asio::error_code error_code{result->first};
+
+                if (!error_code) {
+                        const auto handle{socket.release(error_code)};
+
+                        if (!error_code) {
+                                socket_.assign(result->second.protocol(), handle, error_code);
+                        }
+                }
+
+                return error_code;
+        }
+
+        /*! \brief Keeps the first error of the current synchronous operation. */
+        void fail(asio::error_code error_code)
+        {
+                if (!failure_) {
+                        check_asio_error(error_code);
+                        failure_ = error_code;
+                }
+        }
+
+        void negotiate_protocol()
+        {
+                const std::string version{std::to_string(protocol_version_)};
+                write("*2\r\n$5\r\nHELLO\r\n$" + std::to_string(version.length()) + "\r\n" + version + "\r\n");
+                Result result{receive_response()};
+
+                if (result.type() == Result::Type::ProtocolError || is_failure(result.type())) {
+                        // Server does not know about HELLO (redis < 6.0), so stick with RESP2.
+                        protocol_version_ = 2;
+                }
+        }
+
+        /*! \brief Delivers a pub/sub message or other push message to its callback.
+         *  \param result The message, either an array (RESP2) or push message (RESP3).
+         *  \param other Callback for messages on channels without a callback.
+         */
+        void dispatch_message(const Result& result, const ChannelCallback& other)
+        {
+                if (result.type() != Result::Type::Array && result.type() != Result::Type::Push) {
+                        return;
+                }
+
+                const std::vector<Result>& elements{result.array()};
+                const bool is_message{
+                        elements.size() >= 3 && elements.front().type() == Result::Type::String &&
+                        std::all_of(elements.cbegin(), elements.cend(), [](const Result& element) {
+                                return element.type() == Result::Type::String;
+                        })
+                };
+
+                if (is_message && elements.size() == 3 && elements.front().string() == "message") {
+                        invoke_channel_callback(elements[1].string(), elements[1].string(), elements[2].string(), other);
+                } else if (is_message && elements.size() == 4 && elements.front().string() == "pmessage") {
+                        invoke_channel_callback(elements[1].string(), elements[2].string(), elements[3].string(), other);
+                } else if (result.type() == Result::Type::Push && push_callback_) {
+                        push_callback_(result);
+                }
+        }
+
+        void invoke_channel_callback(const std::string& subscription, const std::string& channel,
+                                     const std::string& message, const ChannelCallback& other)
+        {
+                auto callback{channel_callbacks_.find(subscription)};
+
+                if (callback != channel_callbacks_.end()) {
+                        callback->second(channel, message);
+                } else {
+                        other(channel, message);
+                }
+        }
+
+        Result receive_response()
+        {
+                ResultBuilder builder;
+
+                return std::move(receive_responses(1, builder).front());
+        }
+
+        /*! \brief Receives \p num consecutive replies, each built by \p builder.
+         *
+         *  Builder is either ResultBuilder or ViewBuilder. A single parser is
+         *  used for all replies, which are built in place in the returned vector.
+         */
+        template <typename Builder, typename R = std::decay_t<decltype(std::declval<Builder&>().result())>>
+        std::vector<R> receive_responses(size_t num, Builder& builder)
+        {
+                RespParser parser{builder};
+                std::vector<R> results;
+                results.reserve(num);
+
+                while (results.size() < num) {
+                        // Never reallocates, so builder can safely point into results.
+                        builder.reset(results.emplace_back());
+                        receive_result(parser, builder);
+
+                        R& result{results.back()};
+
+                        if (type_of(result) == Result::Type::Push) {
+                                // Out-of-band data, not a reply to any command.
+                                dispatch_message(to_owned(result), [](auto, auto) {});
+                                results.pop_back();
+                        } else if (is_failure(type_of(result))) {
+                                const R error{result};
+                                results.resize(num, error);
+                        }
+                }
+
+                return results;
+        }
+
+        /*! \brief Streams the next \p num replies to \p handler, see #send_decoded. */
+        void receive_decoded(size_t num, StreamHandler& handler)
+        {
+                if (in_subscribed_mode()) {
+                        return;
+                }
+
+                StreamAdapter adapter{handler};
+                RespParser parser{adapter};
+
+                for (size_t i{}; i < num; i++) {
+                        adapter.reset();
+
+                        if (protocol_version_ == 3 && !receive_pushes(adapter)) {
+                                break;
+                        }
+
+                        if (!receive_result(parser, adapter)) {
+                                break;
+                        }
+                }
+        }
+
+        /*! \brief Receives and dispatches push messages until the next reply starts.
+         *  \return If no I/O error occurred, otherwise it is reported to \p builder.
+         */
+        template <typename Builder>
+        bool receive_pushes(Builder& builder)
+        {
+                ResultBuilder push;
+                RespParser parser{push};
+
+                for (;;) {
+                        if (buffer_.empty()) {
+                                buffer_.commit(read_some(asio::buffer(buffer_.prepare(), buffer_.read_size())));
+
+                                if (failure_) {
+                                        builder.io_error(failure_.message(), failure_type(failure_));
+                                        return false;
+                                }
+                        } else if (*buffer_.data() != '>') {
+                                return true;
+                        } else {
+                                push.reset();
+
+                                if (!receive_result(parser, push)) {
+                                        builder.io_error(push.result().string(), push.result().type());
+                                        return false;
+                                }
+
+                                dispatch_message(push.result(), [](auto, auto) {});
+                        }
+                }
+        }
+
+        /*! \brief Receives the next reply using \p parser, reporting to \p builder.
+         *  \return If no I/O error occurred, otherwise it is reported to \p builder.
+         */
+        template <typename Builder>
+        bool receive_result(RespParser& parser, Builder& builder)
+        {
+                parser.reset();
+
+                for (;;) {
+                        buffer_.consume(parser.parse(buffer_.data(), buffer_.size(), buffer_.scanner()));
+
+                        if (parser.finished()) {
+                                break;
+                        }
+
+                        if (buffer_.empty() && parser.pending_bulk_bytes() >= buffer_.read_size()) {
+                                // Large bulk string, read its payload straight into the result.
+                                parser.commit_bulk(read_some(asio::buffer(
+                                        parser.bulk_destination(), parser.pending_bulk_bytes()
+                                )));
+                        } else {
+                                buffer_.commit(read_some(asio::buffer(buffer_.prepare(), buffer_.read_size())));
+                        }
+
+                        if (failure_) {
+                                builder.io_error(failure_.message(), failure_type(failure_));
+                                return false;
+                        }
+                }
+
+                return true;
+        }
+
+        /*! \brief Starts all submitted requests, coalescing their commands into one write. */
+        void drain_submissions()
+        {
+                Submission* submission{submissions_.exchange(nullptr, std::memory_order_acquire)};
+
+                // The submissions are stacked newest first, so reverse them.
+                Submission* oldest{};
+                while (submission) {
+                        Submission* next{submission->next};
+                        submission->next = oldest;
+                        oldest = submission;
+                        submission = next;
+                }
+
+                while (oldest) {
+                        std::unique_ptr<Submission> current{oldest};
+                        oldest = oldest->next;
+
+                        start_request(*current);
+                }
+
+                start_write();
+                start_read();
+        }
+
+        /*! \brief Queues the commands of \p submission and sets up its deadline and cancellation. */
+        void start_request(Submission& submission)
+        {
+                const std::shared_ptr<AsyncRequest>& request{submission.request};
+                const AsyncOptions& options{submission.options};
+
+                if (!is_connected() || in_subscribed_mode()) {
+                        finish_early(*request, "Not connected or in subscribed mode.");
+                        return;
+                }
+
+                const std::weak_ptr<AsyncRequest> weak_request{request};
+
+                if (options.cancellation) {
+                        request->cancellation = options.cancellation;
+                        request->cancellation_id = options.cancellation->add([this, weak_request]() {
+                                asio::post(strand_, [this, weak_request]() {
+                                        if (auto request{weak_request.lock()}) {
+                                                finish_early(*request, "Command cancelled.");
+                                        }
+                                });
+                        });
+
+                        if (!request->cancellation_id) {
+                                finish_early(*request, "Command cancelled.");
+                                return;
+                        }
+                }
+
+                if (options.deadline.count()) {
+                        request->timer = std::make_unique<asio::steady_timer>(io_context_, options.deadline);
+                        request->timer->async_wait(asio::bind_executor(strand_,
+                                [this, weak_request](const asio::error_code& error_code) {
+                                        auto request{weak_request.lock()};
+
+                                        if (!error_code && request) {
+                                                finish_early(*request, "Deadline exceeded.", Result::Type::Timeout);
+                                        }
+                                }
+                        ));
+                }
+
+                pending_.push_back(request);
+                output_ += submission.commands;
+        }
+
+        /*! \brief Writes #output_ unless a write is already in progress. */
+        void start_write()
+        {
+                if (writing_ || output_.empty()) {
+                        return;
+                }
+
+                writing_ = true;
+                buffer_.unpin();
+                sending_.swap(output_);
+
+                asio::async_write(socket_, asio::buffer(sending_), asio::bind_executor(strand_,
+                        [this](const asio::error_code& error_code, size_t) {
+                                writing_ = false;
+                                sending_.clear();
+
+                                if (error_code) {
+                                        fail_async(error_code);
+                                } else {
+                                        start_write();
+                                }
+                        }
+                ));
+        }
+
+        /*! \brief Reads more replies, unless a read is already in progress or none are pending. */
+        void start_read()
+        {
+                if (reading_ || pending_.empty()) {
+                        return;
+                }
+
+                reading_ = true;
+
+                socket_.async_read_some(asio::buffer(buffer_.prepare(), buffer_.read_size()), asio::bind_executor(strand_,
+                        [this](const asio::error_code& error_code, size_t count) {
+                                reading_ = false;
+                                buffer_.commit(count);
+
+                                if (error_code) {
+                                        fail_async(error_code);
+                                        return;
+                                }
+
+                                receive_async();
+                                start_read();
+                        }
+                ));
+        }
+
+        /*! \brief Passes all completely received replies to their callbacks. */
+        void receive_async()
+        {
+                while (!pending_.empty()) {
+                        buffer_.consume(async_parser_.parse(buffer_.data(), buffer_.size(), buffer_.scanner()));
+
+                        if (!async_parser_.finished()) {
+                                return;
+                        }
+
+                        const Result result{std::move(async_builder_.result())};
+                        async_builder_.reset();
+                        async_parser_.reset();
+
+                        if (result.type() == Result::Type::Push) {
+                                dispatch_message(result, [](auto, auto) {});
+                                continue;
+                        }
+
+                        const std::shared_ptr<AsyncRequest> request{pending_.front()};
+
+                        if (!--request->outstanding) {
+                                pending_.pop_front();
+                                release(*request);
+                        }
+
+                        // Replies of requests which finished early are discarded.
+                        if (request->undelivered) {
+                                request->undelivered--;
+                                request->callback(result);
+                        }
+                }
+        }
+
+        /*! \brief Passes an error to the callback of \p request for all undelivered replies.
+         *  \param type Either Type::IOError or Type::Timeout.
+         */
+        void finish_early(AsyncRequest& request, const std::string& message,
+                          Result::Type type=Result::Type::IOError)
+        {
+                const Result error{type, message};
+
+                for (; request.undelivered; request.undelivered--) {
+                        request.callback(error);
+                }
+        }
+
+        /*! \brief Stops the deadline and cancellation of \p request. */
+        void release(AsyncRequest& request)
+        {
+                request.timer.reset();
+
+                if (request.cancellation) {
+                        request.cancellation->remove(request.cancellation_id);
+                        request.cancellation.reset();
+                }
+        }
+
+        /*! \brief Fails all pending asynchronous commands with an I/O error.
+         *
+         *  The connection is closed, as any replies still arriving
+         *  could not be matched to their commands anymore.
+         */
+        void fail_async(asio::error_code error_code)
+        {
+                check_asio_error(error_code);
+
+                std::deque<std::shared_ptr<AsyncRequest>> pending;
+                pending.swap(pending_);
+
+                asio::error_code ignored;
+                socket_.close(ignored);
+
+                output_.clear();
+                buffer_.clear();
+                async_builder_.reset();
+                async_parser_.reset();
+
+                for (const std::shared_ptr<AsyncRequest>& request: pending) {
+                        release(*request);
+                        finish_early(*request, error_code.message(), failure_type(error_code));
+                }
+        }
+
+        const std::string host_;
+        const std::string port_;
+
+        /*! \brief Timeout in milliseconds of #connect, zero for none. */
+        const size_t timeout_;
+
+        /*! \brief The io_context if none was supplied, must precede #io_context_. */
+        std::optional<asio::io_context> own_io_context_;
+        asio::io_context& io_context_;
+
+        /*! \brief Serializes all handlers of asynchronous commands, which is
+         *         needed if #io_context_ is run by multiple threads.
+         */
+        asio::strand<asio::io_context::executor_type> strand_;
+
+        /*! \brief Either a TCP socket or a unix domain socket, see #resolve. */
+        asio::generic::stream_protocol::socket socket_;
+        ReceiveBuffer buffer_;
+        ResultArena view_arena_;
+        int protocol_version_;
+
+        /*! \brief Time allowed for each command, zero for none. */
+        std::chrono::milliseconds command_timeout_;
+
+        /*! \brief End of the current synchronous operation, see #begin. */
+        std::chrono::steady_clock::time_point deadline_;
+
+        /*! \brief First error of the current synchronous operation, which fails all further reads and writes. */
+        asio::error_code failure_;
+
+        std::unordered_map<std::string, ChannelCallback> channel_callbacks_;
+        PushCallback push_callback_;
+
+        /*! \brief Submitted requests not yet started by #drain_submissions, newest first.
+         *
+         *  A lock-free stack, so any number of threads can submit requests while
+         *  the I/O loop on #strand_ takes all of them at once.
+         */
+        std::atomic<Submission*> submissions_;
+
+        /*! \brief Asynchronous commands without (all) replies, oldest first. */
+        std::deque<std::shared_ptr<AsyncRequest>> pending_;
+
+        /*! \brief Asynchronous commands not yet written. */
+        std::string output_;
+
+        /*! \brief Asynchronous commands currently being written. */
+        std::string sending_;
+
+        /*! \brief Builds the reply of the oldest pending asynchronous command. */
+        ResultBuilder async_builder_;
+        RespParser async_parser_;
+
+        /*! \brief Indicates if an asynchronous read or write is in progress. */
+        bool reading_, writing_;
+
+};
+
+
+namespace {
+
+/*! \brief Creates the implementation of a client for \p address in the format "<host>[:<port>]"
+ *         or "unix://<path>".
+ */
+std::unique_ptr<ClientImpl> make_client_impl(asio::io_context* io_context, const std::string& address, size_t timeout)
+{
+        const std::string unix_scheme{"unix://"};
+
+        if (!address.compare(0, unix_scheme.length(), unix_scheme)) {
+                // A unix domain socket has no port, see ClientImpl::resolve.
+                return std::make_unique<ClientImpl>(io_context, address.substr(unix_scheme.length()), "", timeout);
+        }
+
+        std::string host, port;
+        std::stringstream sstream{address};
+
+        std::getline(sstream, host, ':');
+        std::getline(sstream, port);
+
+        if (port.empty()) {
+                port = "6379";
+        }
+
+        return std::make_unique<ClientImpl>(io_context, host, port, timeout);
+}
+
+}
+
+
+struct CancellationSignal::State {
+        std::mutex mutex;
+        bool cancelled{};
+        size_t next_id{1};
+        std::unordered_map<size_t, std::function<void()>> handlers;
+};
+
+
+CancellationSignal::CancellationSignal() : state_{std::make_unique<State>()} { }
+CancellationSignal::~CancellationSignal() { }
+
+void CancellationSignal::cancel()
+{
+        std::unordered_map<size_t, std::function<void()>> handlers;
+
+        {
+                std::lock_guard<std::mutex> lock{state_->mutex};
+                state_->cancelled = true;
+                handlers.swap(state_->handlers);
+        }
+
+        for (const auto& handler: handlers) {
+                handler.second();
+        }
+}
+
+bool CancellationSignal::cancelled() const
+{
+        std::lock_guard<std::mutex> lock{state_->mutex};
+
+        return state_->cancelled;
+}
+
+size_t CancellationSignal::add(std::function<void()> handler)
+{
+        std::lock_guard<std::mutex> lock{state_->mutex};
+
+        if (state_->cancelled) {
+                return 0;
+        }
+
+        state_->handlers.emplace(state_->next_id, std::move(handler));
+        return state_->next_id++;
+}
+
+void CancellationSignal::remove(size_t id)
+{
+        std::lock_guard<std::mutex> lock{state_->mutex};
+
+        state_->handlers.erase(id);
+}
+
+
+Client::Client() : Client{"localhost", "6379"} { }
+
+
+Client::Client(const std::string& address, size_t timeout)
+        : impl_{make_client_impl(nullptr, address, timeout)}
+{
+}
+
+
+Client::Client(asio::io_context& io_context, const std::string& address, size_t timeout)
+        : impl_{make_client_impl(&io_context, address, timeout)}
+{
+}
+
+
+Client::Client(const std::string& host, const std::string& port, size_t timeout)
+        : impl_{std::make_unique<ClientImpl>(nullptr, host, port, timeout)}
+{
+}
+
+
+Client::~Client() { }
+
+
+void Client::connect() { impl_->connect(); }
+void Client::close() { impl_->close(); }
+const std::string& Client::host() const { return impl_->host(); }
+const std::string& Client::port() const { return impl_->port(); }
+bool Client::is_connected() const { return impl_->is_connected(); }
+int Client::protocol_version() const { return impl_->protocol_version(); }
+void Client::protocol_version(int version) { impl_->protocol_version(version); }
+
+std::chrono::milliseconds Client::command_timeout() const { return impl_->command_timeout(); }
+void Client::command_timeout(std::chrono::milliseconds timeout) { impl_->command_timeout(timeout); }
+
+bool Client::in_subscribed_mode() const
+{
+        return impl_->in_subscribed_mode();
+}
+
+Client& Client::subscribe(const std::string& channel, ChannelCallback callback)
+{
+        impl_->channel_callbacks()[channel] = callback;
+        command("subscribe", channel);
+
+        return *this;
+}
+
+Client& Client::psubscribe(const std::string& pattern, ChannelCallback callback)
+{
+        impl_->channel_callbacks()[pattern] = callback;
+        command("psubscribe", pattern);
+
+        return *this;
+}
+
+Result Client::finish_command(const SerializedCommand& command)
+{
+        return command.empty() ? Result{} : impl_->send(command);
+}
+
+ResultView Client::ArenaClient::finish_command(const SerializedCommand& command)
+{
+        return command.empty() ? ResultView{} : client_.impl_->send(command, arena_);
+}
+
+ResultView Client::ViewClient::finish_command(const SerializedCommand& command)
+{
+        return command.empty() ? ResultView{} : client_.impl_->send_view(command);
+}
+
+void Client::StreamClient::finish_command(const SerializedCommand& command)
+{
+        if (command.empty()) {
+                return;
+        }
+
+        if (dispatch_pushes_) {
+                client_.impl_->send_decoded(command, handler_);
+        } else {
+                client_.impl_->send_stream(command, handler_);
+        }
+}
+
+void Client::AsyncClient::finish_command(const SerializedCommand& command)
+{
+        if (command.empty() || is_subscribe_command(command.data())) {
+                callback_(Result{});
+                return;
+        }
+
+        client_.impl_->send_async(command, callback_, options_);
+}
+
+void Client::run()
+{
+        impl_->run();
+}
+
+Client& Client::on_push(PushCallback callback)
+{
+        impl_->push_callback(callback);
+
+        return *this;
+}
+
+void Client::listen_for_messages(ChannelCallback other)
+{
+        impl_->listen_for_messages(other);
+}
+
+std::vector<Result> Client::Pipeline::send()
+{
+        if (!count_) {
+                return {};
+        }
+
+        auto results = client_.impl_->send_batch(commands_, count_, timeout_);
+
+        clear();
+        return results;
+}
+
+std::vector<ResultView> Client::Pipeline::send(ResultArena& arena)
+{
+        if (!count_) {
+                return {};
+        }
+
+        auto results = client_.impl_->send_batch(commands_, count_, arena, timeout_);
+
+        clear();
+        return results;
+}
+
+void Client::Pipeline::send(StreamHandler& handler)
+{
+        handler.begin_array(Result::Type::Array, count_);
+
+        if (count_) {
+                client_.impl_->send_decoded(commands_, count_, handler, timeout_);
+                clear();
+        }
+
+        handler.end_array();
+}
+
+void Client::Pipeline::clear()
+{
+        // Keeps the capacity, so reusing the pipeline does not allocate again.
+        commands_.clear();
+        count_ = 0;
+}
+
+void Client::Pipeline::send_async(PipelineCallback callback, const AsyncOptions& options)
+{
+        if (!count_) {
+                callback({});
+                return;
+        }
+
+        auto replies{std::make_shared<std::vector<Result>>()};
+        replies->reserve(count_);
+
+        client_.impl_->send_async(commands_, count_, [replies, count{count_}, callback](const Result& reply) {
+                replies->push_back(reply);
+
+                if (replies->size() == count) {
+                        callback(std::move(*replies));
+                }
+        }, options);
+
+        clear();
+}
+
+Client::StreamingPipeline::StreamingPipeline(Client& client, ReplyCallback callback, size_t flush_commands,
+                                             size_t flush_bytes, size_t max_in_flight)
+        : client_{client}, callback_{callback}, flush_commands_{flush_commands}, flush_bytes_{flush_bytes},
+          max_in_flight_{max_in_flight}, count_{}, in_flight_{}
+{
+}
+
+Client::StreamingPipeline::~StreamingPipeline()
+{
+        finish();
+}
+
+void Client::StreamingPipeline::flush()
+{
+        if (count_) {
+                // Replies may arrive before the whole batch is written.
+                in_flight_ += count_;
+                count_ = 0;
+
+                client_.impl_->send_only(commands_, [this]() { receive(0); });
+                commands_.clear();
+        }
+
+        receive(in_flight_ > max_in_flight_ ? in_flight_ - max_in_flight_ : 0);
+}
+
+void Client::StreamingPipeline::finish()
+{
+        flush();
+        receive(in_flight_);
+}
+
+void Client::StreamingPipeline::receive(size_t min)
+{
+        if (in_flight_) {
+                in_flight_ -= client_.impl_->receive_available(min, in_flight_, callback_);
+        }
+}
+
+Client::StreamingPipeline& Client::StreamingPipeline::finish_command(const SerializedCommand& command)
+{
+        if (!command.empty() && !is_subscribe_command(command.data())) {
+                command.append_to(commands_);
+                count_++;
+
+                if (count_ >= flush_commands_ || commands_.size() >= flush_bytes_) {
+                        flush();
+                }
+        }
+
+        return *this;
+}
+
+Client::Pipeline& Client::Pipeline::finish_command(const SerializedCommand& command)
+{
+        if (!command.empty() && !is_subscribe_command(command.data())) {
+                // Referenced arguments must be copied, they are gone until #send.
+                command.append_to(commands_);
+                count_++;
+        }
+
+        return *this;
+}
+
+
+struct MultiplexedClient::Loop {
+        Loop() : work{asio::make_work_guard(io_context)}, thread{[this]() { io_context.run(); }} { }
+
+        asio::io_context io_context;
+        asio::executor_work_guard<asio::io_context::executor_type> work;
+        std::thread thread;
+};
+
+
+MultiplexedClient::MultiplexedClient(const std::string& address, size_t timeout)
+        : loop_{std::make_unique<Loop>()}, client_{loop_->io_context, address, timeout}
+{
+}
+
+
+MultiplexedClient::~MultiplexedClient()
+{
+        // Commands without a deadline would keep the I/O thread waiting for a stalled server forever.
+        client_.impl_->abort_async();
+
+        loop_->work.reset();
+        loop_->thread.join();
+}
+
+
+bool MultiplexedClient::on_io_thread() const
+{
+        return loop_->thread.get_id() == std::this_thread::get_id();
 }
 
 
@@ -410,7 +1839,7 @@ bool Redlock::lock_instance(std::shared_ptr<Client> client, size_t ttl)
 {
         auto result{client->command("set", resource_name_, lock_value_, "NX", "PX", ttl)};
 
-        return result.type == Result::Type::String && result.string == "OK";
+        return result.type() == Result::Type::String && result.string() == "OK";
 }
 
 void Redlock::unlock_instance(std::shared_ptr<Client> client)
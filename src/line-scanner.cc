@@ -0,0 +1,140 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <cstring>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define RESPLY_X86_SIMD
+#include <immintrin.h>
+#endif
+
+#include "line-scanner.h"
+
+
+namespace {
+
+/*! \brief Computes the LF bitmask of exactly 64 bytes at \p data. */
+typedef std::uint64_t (*ScanFunction)(const char* data);
+
+std::uint64_t scan_scalar(const char* data)
+{
+        std::uint64_t mask{};
+
+        for (unsigned i{}; i < 64; i++) {
+                mask |= std::uint64_t{data[i] == '\n'} << i;
+        }
+
+        return mask;
+}
+
+#ifdef RESPLY_X86_SIMD
+
+__attribute__((target("sse2")))
+std::uint64_t scan_sse2(const char* data)
+{
+        const __m128i lf{_mm_set1_epi8('\n')};
+        std::uint64_t mask{};
+
+        for (unsigned i{}; i < 4; i++) {
+                __m128i chunk{_mm_loadu_si128(reinterpret_cast<const __m128i*>(data + i * 16))};
+                std::uint64_t bits{static_cast<std::uint16_t>(_mm_movemask_epi8(_mm_cmpeq_epi8(chunk, lf)))};
+
+                mask |= bits << (i * 16);
+        }
+
+        return mask;
+}
+
+__attribute__((target("avx2")))
+std::uint64_t scan_avx2(const char* data)
+{
+        const __m256i lf{_mm256_set1_epi8('\n')};
+
+        __m256i low{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data))};
+        __m256i high{_mm256_loadu_si256(reinterpret_cast<const __m256i*>(data + 32))};
+
+        std::uint64_t low_bits{static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(low, lf)))};
+        std::uint64_t high_bits{static_cast<std::uint32_t>(_mm256_movemask_epi8(_mm256_cmpeq_epi8(high, lf)))};
+
+        return low_bits | high_bits << 32;
+}
+
+#endif
+
+struct Implementation {
+        ScanFunction scan;
+        const char* name;
+};
+
+Implementation select_implementation()
+{
+#ifdef RESPLY_X86_SIMD
+        __builtin_cpu_init();
+
+        if (__builtin_cpu_supports("avx2")) {
+                return {scan_avx2, "avx2"};
+        }
+
+        if (__builtin_cpu_supports("sse2")) {
+                return {scan_sse2, "sse2"};
+        }
+#endif
+        return {scan_scalar, "scalar"};
+}
+
+/*! \brief The block scanner, selected once when the library is loaded. */
+const Implementation selected{select_implementation()};
+
+}
+
+
+const char* LineScanner::find_in_next_blocks(const char* position)
+{
+        while (position < end_) {
+                if (position < block_ || static_cast<std::size_t>(position - block_) >= BLOCK_SIZE) {
+                        scan(position);
+                }
+
+                // Ignore everything in front of position.
+                std::uint64_t mask{mask_ & (~std::uint64_t{} << (position - block_))};
+
+                if (mask) {
+                        return block_ + count_trailing_zeros(mask);
+                }
+
+                if (static_cast<std::size_t>(end_ - block_) <= BLOCK_SIZE) {
+                        break;
+                }
+
+                position = block_ + BLOCK_SIZE;
+        }
+
+        return nullptr;
+}
+
+
+const char* LineScanner::implementation()
+{
+        return selected.name;
+}
+
+
+void LineScanner::scan(const char* position)
+{
+        block_ = position;
+
+        if (static_cast<std::size_t>(end_ - position) >= BLOCK_SIZE) {
+                mask_ = selected.scan(position);
+        } else {
+                // Never read past the end, scan a zero-padded copy instead.
+                char padded[BLOCK_SIZE] = {};
+                std::memcpy(padded, position, end_ - position);
+
+                mask_ = selected.scan(padded);
+        }
+}
@@ -44,7 +44,7 @@ namespace {
 
 const std::string GLOBAL_LOGGER_NAME{"Proxy"};
 
-void resply_result_to_rslp_data(rslp::Command_Data* data, const resply::Result& result);
+void resply_result_to_rslp_data(rslp::Command_Data* data, const resply::ResultView& result);
 
 struct Options {
         bool daemonize;
@@ -215,25 +215,43 @@ void daemonize_process()
         ::freopen("/dev/null", "w", ::stderr);
 }
 
-void resply_result_to_rslp(rslp::Command& command, const resply::Result& result)
+/*! \brief Formats a RESP3 double in the shortest notation which reads back exactly, like command arguments. */
+std::string format_floating(double value)
+{
+        const auto formatted{resply::CommandArgument<double>::convert(value)};
+
+        return std::string{std::string_view{formatted}};
+}
+
+void resply_result_to_rslp(rslp::Command& command, const resply::ResultView& result)
 {
         using Type = resply::Result::Type;
 
         switch (result.type) {
                 case Type::ProtocolError:
                 case Type::IOError:
-                        command.add_data()->set_err(result.string);
+                case Type::Timeout:
+                        command.add_data()->set_err(result.string.data(), result.string.size());
                         break;
 
                 case Type::String:
-                        command.add_data()->set_str(result.string);
+                case Type::BigNumber:
+                        command.add_data()->set_str(result.string.data(), result.string.size());
+                        break;
+
+                case Type::Double:
+                        command.add_data()->set_str(format_floating(result.floating));
                         break;
 
                 case Type::Integer:
+                case Type::Boolean:
                         command.add_data()->set_int_(result.integer);
                         break;
 
                 case Type::Array:
+                case Type::Map:
+                case Type::Set:
+                case Type::Push:
                         for (const auto& element: result.array) {
                                 resply_result_to_rslp_data(command.add_data(), element);
                         }
@@ -245,20 +263,29 @@ void resply_result_to_rslp(rslp::Command& command, const resply::Result& result)
         }
 }
 
-void resply_result_to_rslp_data(rslp::Command_Data* data, const resply::Result& result)
+void resply_result_to_rslp_data(rslp::Command_Data* data, const resply::ResultView& result)
 {
         using Type = resply::Result::Type;
 
         switch (result.type) {
         case Type::String:
-                data->set_str(result.string);
+        case Type::BigNumber:
+                data->set_str(result.string.data(), result.string.size());
+                break;
+
+        case Type::Double:
+                data->set_str(format_floating(result.floating));
                 break;
 
         case Type::Integer:
+        case Type::Boolean:
                 data->set_int_(result.integer);
                 break;
 
         case Type::Array:
+        case Type::Map:
+        case Type::Set:
+        case Type::Push:
                 for (const auto& element: result.array) {
                         resply_result_to_rslp(*data->mutable_array(), element);
                 }
@@ -316,7 +343,7 @@ public:
                                 resply_command.push_back(arg.str());
                         }
 
-                        resply::Result result{client_.command(resply_command)};
+                        resply::ResultView result{client_.view().command(resply_command)};
 
                         rslp::Command response;
                         resply_result_to_rslp(response, result);
@@ -455,7 +482,7 @@ public:
 
                 logger_->debug("[{}] execute(): {}", context->peer(), request->ShortDebugString());
 
-                resply::Result result{client_.command(command)};
+                resply::ResultView result{client_.view().command(command)};
                 resply_result_to_rslp(*response, result);
 
                 return grpc::Status::OK;
@@ -484,7 +511,7 @@ public:
 
                 logger_->debug("[{}] subscribe(): {}", context->peer(), request->ShortDebugString());
 
-                resply::Result result{client_.command(command)};
+                resply::ResultView result{client_.view().command(command)};
 
                 rslp::Command response;
                 resply_result_to_rslp(response, result);
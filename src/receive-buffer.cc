@@ -0,0 +1,76 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <cstring>
+
+#include "receive-buffer.h"
+
+
+void ReceiveBuffer::consume(std::size_t count)
+{
+        begin_ += std::min(count, size());
+
+        if (empty() && !pinned_) {
+                clear();
+        }
+}
+
+
+char* ReceiveBuffer::prepare()
+{
+        if (empty() && !pinned_ && capacity_ > SHRINK_FACTOR * read_size_) {
+                // Only needed for some large reply, don't keep it for the lifetime of the connection.
+                clear();
+                storage_.reset();
+                capacity_ = 0;
+        }
+
+        if (capacity_ - end_ >= read_size_) {
+                return storage_.get() + end_;
+        }
+
+        // Everything from here on has to be kept.
+        const std::size_t keep{pinned_ ? pin_ : begin_};
+        const std::size_t kept{end_ - keep};
+
+        if (capacity_ - kept >= read_size_) {
+                // Enough room if the kept data is moved to the front.
+                std::memmove(storage_.get(), storage_.get() + keep, kept);
+        } else {
+                std::size_t capacity{std::max(capacity_ * 2, kept + read_size_)};
+                std::unique_ptr<char[]> storage{new char[capacity]};
+
+                if (kept) {
+                        std::memcpy(storage.get(), storage_.get() + keep, kept);
+                }
+
+                storage_ = std::move(storage);
+                capacity_ = capacity;
+        }
+
+        begin_ -= keep;
+        end_ = kept;
+        pin_ = 0;
+
+        return storage_.get() + end_;
+}
+
+
+void ReceiveBuffer::commit(std::size_t count)
+{
+        end_ += count;
+        scanner_.reset(storage_.get() + end_);
+
+        if (count == read_size_) {
+                // The read filled the whole region, there is probably more to come.
+                read_size_ = std::min(read_size_ * 2, MAX_READ_SIZE);
+        } else if (count < read_size_ / 4) {
+                read_size_ = std::max(read_size_ / 2, MIN_READ_SIZE);
+        }
+}
@@ -9,6 +9,10 @@
 #include <iostream>
 #include <string>
 #include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <limits>
+#include <cctype>
 
 #include "resp-parser.h"
 
@@ -22,9 +26,128 @@ enum RespTypes {
         ERROR = '-',
         INTEGER = ':',
         BULK_STRING = '$',
-        ARRAY = '*'
+        ARRAY = '*',
+
+        // RESP3, see <https://github.com/antirez/RESP3/blob/master/spec.md>
+        NIL = '_',
+        DOUBLE = ',',
+        BOOLEAN = '#',
+        BIG_NUMBER = '(',
+        BLOB_ERROR = '!',
+        VERBATIM_STRING = '=',
+        MAP = '%',
+        SET = '~',
+        ATTRIBUTE = '|',
+        PUSH = '>'
 };
 
+/*! \brief Strips the CR of a CRLF line ending if present. */
+const char* strip_cr(const char* begin, const char* eol)
+{
+        return eol != begin && *(eol - 1) == '\r' ? eol - 1 : eol;
+}
+
+/*! \brief Decodes a decimal integer as used for integers and sizes.
+ *  \param value Receives the integer.
+ *  \return If [begin, end) is a well-formed integer which fits into \p value.
+ *
+ *  Unlike std::strtoll, this does not care about locales or leading
+ *  whitespace and works on data which is not null-terminated.
+ */
+bool decode_integer(const char* begin, const char* end, long long& value)
+{
+        const bool negative{begin != end && *begin == '-'};
+        begin += negative;
+
+        if (begin == end) {
+                return false;
+        }
+
+        // The magnitude of the smallest value is one more than of the largest.
+        const unsigned long long limit{
+                static_cast<unsigned long long>(std::numeric_limits<long long>::max()) + negative
+        };
+        unsigned long long magnitude{};
+
+        for (; begin != end; begin++) {
+                const unsigned digit{static_cast<unsigned char>(*begin) - static_cast<unsigned>('0')};
+
+                if (digit > 9 || magnitude > (limit - digit) / 10) {
+                        return false;
+                }
+
+                magnitude = magnitude * 10 + digit;
+        }
+
+        value = negative ? static_cast<long long>(0 - magnitude) : static_cast<long long>(magnitude);
+        return true;
+}
+
+/*! \brief Decodes a RESP3 double.
+ *  \param value Receives the double.
+ *  \return If [begin, end) is a well-formed double.
+ */
+bool decode_double(const char* begin, const char* end, double& value)
+{
+        return resply::detail::parse_floating(std::string_view(begin, end - begin), value);
+}
+
+/*! \brief Maps a RESP type to the type of the resulting element. */
+Result::Type result_type(char type)
+{
+        switch (type) {
+        case RespTypes::ERROR:
+        case RespTypes::BLOB_ERROR:
+                return Result::Type::ProtocolError;
+
+        case RespTypes::INTEGER:
+                return Result::Type::Integer;
+
+        case RespTypes::DOUBLE:
+                return Result::Type::Double;
+
+        case RespTypes::BOOLEAN:
+                return Result::Type::Boolean;
+
+        case RespTypes::BIG_NUMBER:
+                return Result::Type::BigNumber;
+
+        case RespTypes::ARRAY:
+                return Result::Type::Array;
+
+        case RespTypes::MAP:
+        case RespTypes::ATTRIBUTE:
+                return Result::Type::Map;
+
+        case RespTypes::SET:
+                return Result::Type::Set;
+
+        case RespTypes::PUSH:
+                return Result::Type::Push;
+
+        case RespTypes::NIL:
+                return Result::Type::Nil;
+
+        default:
+                return Result::Type::String;
+        }
+}
+
+}
+
+
+void RespParser::reset()
+{
+        stack_.clear();
+        discarding_ = 0;
+        state_ = State::NeedType;
+        type_ = 0;
+        remaining_bytes_ = READ_UNTIL_EOL;
+        destination_ = nullptr;
+        prefix_bytes_ = 0;
+        reporting_bulk_ = false;
+        offset_ = 0;
+        input_ = nullptr;
 }
 
 
@@ -32,172 +155,354 @@ bool RespParser::parse(std::istream& stream)
 {
         std::string line;
 
-        while (state_ != State::Finished && !stream.eof()) {
-                switch (state_) {
-                case State::NeedType:
-                        parse_type(stream.get());
-                        break;
+        while (state_ != State::Finished && stream) {
+                if (std::size_t count{pending_bulk_bytes()}) {
+                        stream.read(bulk_destination(), count);
+                        commit_bulk(stream.gcount());
+                } else if (std::getline(stream, line)) {
+                        if (!stream.eof()) {
+                                line.push_back('\n');
+                        }
 
-                case State::NeedSize:
-                        std::getline(stream, line);
-                        line.pop_back();
-                        parse_size(line);
-                        break;
+                        parse(line.data(), line.length());
+                }
+        }
 
-                case State::NeedData: {
-                        std::getline(stream, line);
-                        if (line.back() == '\r') {
-                                line.push_back('\n');
+        return state_ != State::Finished;
+}
+
+
+std::size_t RespParser::parse(const char* data, std::size_t length)
+{
+        LineScanner scanner{data + length};
+
+        return parse(data, length, scanner);
+}
+
+
+std::size_t RespParser::parse(const char* data, std::size_t length, LineScanner& scanner)
+{
+        const char* pos{data};
+        const char* const end{data + length};
+
+        input_ = data;
+
+        while (state_ != State::Finished && pos != end) {
+                if (state_ == State::NeedType) {
+                        parse_type(*pos++);
+                        continue;
+                }
+
+                if (state_ == State::NeedData && remaining_bytes_ != READ_UNTIL_EOL) {
+                        std::size_t consumed{parse_bulk(pos, end)};
+                        if (!consumed) {
+                                break;
                         }
 
-                        parse_data(line);
-                        break;
+                        pos += consumed;
+                        continue;
                 }
 
-                case State::Finished:
+                const char* eol{scanner.find(pos)};
+                if (!eol) {
+                        // Incomplete line, wait for more data.
                         break;
                 }
 
-                // Update internal stream state.
-                // Especially, sets the eofbit appropriatly if we read all data.
-                // This is needed because when using .read() does not update the
-                // internal stream state, i.e. does not set eofbit even if all data
-                // was read.
-                stream.peek();
-        }
+                if (state_ == State::NeedSize) {
+                        parse_size(pos, strip_cr(pos, eol));
+                } else {
+                        parse_line(pos, strip_cr(pos, eol));
+                }
 
-        if (result_.type == Result::Type::Array && !remaining_elements_) {
-                state_ = State::Finished;
+                pos = eol + 1;
         }
 
-        return state_ != State::Finished;
+        offset_ += pos - data;
+        return pos - data;
 }
 
 
-void RespParser::parse_type(char type)
+std::size_t RespParser::pending_bulk_bytes() const
 {
-        if (result_.type == Result::Type::Array) {
-                Result result;
-                parse_type(type, result);
-                result_.array.push_back(result);
-        } else {
-                parse_type(type, result_);
-        }
+        bool direct{state_ == State::NeedData && destination_ && !prefix_bytes_};
+
+        return direct && remaining_bytes_ > 0 ? remaining_bytes_ : 0;
 }
 
 
-void RespParser::parse_type(char type, Result& result)
+void RespParser::commit_bulk(std::size_t count)
+{
+        count = std::min(count, pending_bulk_bytes());
+
+        destination_ += count;
+        remaining_bytes_ -= count;
+        offset_ += count;
+}
+
+
+void RespParser::parse_type(char type)
 {
+        type_ = type;
+        remaining_bytes_ = READ_UNTIL_EOL;
+
         switch (type) {
         case RespTypes::SIMPLE_STRING:
-                result.type = Result::Type::String;
-                state_ = State::NeedData;
-                break;
-
         case RespTypes::ERROR:
-                result.type = Result::Type::ProtocolError;
-                state_ = State::NeedData;
-                break;
-
         case RespTypes::INTEGER:
-                result.type = Result::Type::Integer;
+        case RespTypes::NIL:
+        case RespTypes::DOUBLE:
+        case RespTypes::BOOLEAN:
+        case RespTypes::BIG_NUMBER:
                 state_ = State::NeedData;
                 break;
 
         case RespTypes::BULK_STRING:
-                result.type = Result::Type::String;
-                state_ = State::NeedSize;
-                break;
-
+        case RespTypes::BLOB_ERROR:
+        case RespTypes::VERBATIM_STRING:
         case RespTypes::ARRAY:
-                result.type = Result::Type::Array;
+        case RespTypes::MAP:
+        case RespTypes::SET:
+        case RespTypes::ATTRIBUTE:
+        case RespTypes::PUSH:
                 state_ = State::NeedSize;
                 break;
 
         default:
-                result.type = Result::Type::ProtocolError;
-                result.string = "Parsing error.";
-                state_ = State::Finished;
+                fail("Parsing error.");
                 break;
         }
 }
 
 
-void RespParser::parse_size(const std::string& buffer)
+void RespParser::parse_size(const char* begin, const char* end)
 {
-        long size{std::stol(buffer)};
+        if (begin != end && *begin == '?') {
+                fail("Streamed types are not supported.");
+                return;
+        }
 
-        if (size == -1) {
-                Result& result = result_.type == Result::Type::Array ? result_.array.back() : result_;
+        long long size;
 
-                result.type = Result::Type::Nil;
-                state_ = State::Finished;
-        } else {
-                if (result_.type == Result::Type::Array && !remaining_elements_) {
-                        remaining_elements_ = size;
-                        state_ = State::NeedType;
+        if (!decode_integer(begin, end, size)) {
+                fail("Invalid size.");
+                return;
+        }
+
+        if (size < 0) {
+                if (!discarding_) {
+                        handler_.on_nil();
+                }
+
+                finish_element();
+                return;
+        }
+
+        if (type_ == RespTypes::BULK_STRING || type_ == RespTypes::BLOB_ERROR ||
+            type_ == RespTypes::VERBATIM_STRING) {
+                if (size > MAX_BULK_LENGTH) {
+                        fail("Bulk string exceeds maximum length.");
+                        return;
+                }
+
+                // Verbatim strings start with their format, e.g. "txt:", which is stripped.
+                prefix_bytes_ = type_ == RespTypes::VERBATIM_STRING && size >= 4 ? 4 : 0;
+
+                if (string_mode_ != RespHandler::StringMode::Copy) {
+                        // Reported once the payload arrives, see #parse_bulk.
+                        reporting_bulk_ = !discarding_;
+                        destination_ = nullptr;
                 } else {
-                        remaining_bytes_ = size;
-                        state_ = State::NeedData;
+                        // The whole payload is copied into place in (at most) a
+                        // few chunks, see #parse_bulk and #bulk_destination.
+                        destination_ = discarding_ ? nullptr : handler_.on_string(result_type(type_), size - prefix_bytes_);
                 }
+
+                remaining_bytes_ = size;
+                state_ = State::NeedData;
+                return;
+        }
+
+        const bool attribute{type_ == RespTypes::ATTRIBUTE};
+
+        if (size > MAX_AGGREGATE_SIZE) {
+                fail("Aggregate exceeds maximum size.");
+                return;
+        }
+
+        if (type_ == RespTypes::MAP || attribute) {
+                // Maps are reported as flat key-value sequence.
+                size *= 2;
+        }
+
+        if (size && stack_.size() >= MAX_NESTING_DEPTH) {
+                fail("Arrays are nested too deeply.");
+                return;
+        }
+
+        if (!attribute && !discarding_) {
+                handler_.on_aggregate(result_type(type_), size);
+        }
+
+        if (size) {
+                stack_.push_back({size, attribute});
+                discarding_ += attribute;
+                state_ = State::NeedType;
+        } else if (attribute) {
+                // Empty attribute, the actual reply follows.
+                state_ = State::NeedType;
+        } else {
+                if (!discarding_) {
+                        handler_.on_aggregate_end();
+                }
+
+                finish_element();
         }
 }
 
 
-void RespParser::parse_data(const std::string& buffer)
+void RespParser::parse_line(const char* begin, const char* end)
 {
-        Result::Type type{result_.type == Result::Type::Array ? result_.array.back().type : result_.type};
+        long long integer{};
+        double floating{};
 
-        switch (type) {
-        case Result::Type::String:
-        case Result::Type::ProtocolError:
-        case Result::Type::IOError:
-                if (result_.type == Result::Type::Array) {
-                        result_.array.back().string += buffer;
-                } else {
-                        result_.string += buffer;
+        // Malformed lines fail the reply, even if it would be discarded.
+        if (type_ == RespTypes::INTEGER && !decode_integer(begin, end, integer)) {
+                fail("Invalid integer.");
+                return;
+        }
+
+        if (type_ == RespTypes::BOOLEAN) {
+                if (end - begin != 1 || (*begin != 't' && *begin != 'f')) {
+                        fail("Invalid boolean.");
+                        return;
                 }
 
-                if (remaining_bytes_ == READ_UNTIL_EOL) {
-                        // Response was a simple string
-                        state_ = State::Finished;
-                        result_.string.pop_back();
-                        result_.string.pop_back();
-                } else {
-                        remaining_bytes_ -= buffer.length();
-
-                        if (remaining_bytes_ <= 0) {
-                                if (result_.type == Result::Type::Array) {
-                                        result_.array.back().string.pop_back();
-                                        result_.array.back().string.pop_back();
-                                        remaining_elements_--;
-                                } else {
-                                        state_ = State::Finished;
-                                        result_.string.pop_back();
-                                        result_.string.pop_back();
-                                }
+                integer = *begin == 't';
+        }
+
+        if (type_ == RespTypes::DOUBLE && !decode_double(begin, end, floating)) {
+                fail("Invalid double.");
+                return;
+        }
+
+        if (!discarding_) {
+                switch (type_) {
+                case RespTypes::INTEGER:
+                        handler_.on_integer(Result::Type::Integer, integer);
+                        break;
+
+                case RespTypes::BOOLEAN:
+                        handler_.on_integer(Result::Type::Boolean, integer);
+                        break;
+
+                case RespTypes::DOUBLE:
+                        handler_.on_double(floating);
+                        break;
+
+                case RespTypes::NIL:
+                        handler_.on_nil();
+                        break;
+
+                default:
+                        if (string_mode_ == RespHandler::StringMode::InPlace) {
+                                handler_.on_string_at(result_type(type_), offset_of(begin), end - begin);
+                        } else if (string_mode_ == RespHandler::StringMode::Chunked) {
+                                handler_.on_string_chunk(result_type(type_), begin, end - begin, true);
+                        } else {
+                                char* destination{handler_.on_string(result_type(type_), end - begin)};
+                                std::copy(begin, end, destination);
                         }
+
+                        break;
                 }
+        }
 
-                break;
+        finish_element();
+}
 
-        case Result::Type::Integer:
-                if (result_.type == Result::Type::Array) {
-                        result_.array.emplace_back(std::stoll(buffer));
-                        remaining_elements_--;
-                } else {
-                        result_.integer = std::stoll(buffer);
-                        state_ = State::Finished;
+
+std::size_t RespParser::parse_bulk(const char* begin, const char* end)
+{
+        if (reporting_bulk_ && string_mode_ == RespHandler::StringMode::InPlace) {
+                handler_.on_string_at(result_type(type_), offset_of(begin) + prefix_bytes_,
+                                      remaining_bytes_ - prefix_bytes_);
+                reporting_bulk_ = false;
+        }
+
+        if (remaining_bytes_ > 0) {
+                std::size_t count{std::min<std::size_t>(remaining_bytes_, end - begin)};
+                std::size_t skipped{std::min(count, prefix_bytes_)};
+
+                if (destination_) {
+                        std::memcpy(destination_, begin + skipped, count - skipped);
+                        destination_ += count - skipped;
                 }
 
-                break;
+                prefix_bytes_ -= skipped;
+                remaining_bytes_ -= count;
 
-        case Result::Type::Array:
-        default:
-                break;
+                if (reporting_bulk_ && (count > skipped || !remaining_bytes_)) {
+                        handler_.on_string_chunk(result_type(type_), begin + skipped, count - skipped, !remaining_bytes_);
+                        reporting_bulk_ = remaining_bytes_ > 0;
+                }
+
+                return count;
         }
 
-        if (remaining_bytes_ <= 0 && remaining_elements_ > 0) {
-                state_ = State::NeedType;
+        // Payload is complete, wait for the trailing CRLF.
+        if (end - begin < 2) {
+                return 0;
         }
+
+        // Otherwise the length does not match the payload, and everything after it would be misread.
+        if (begin[0] != '\r' || begin[1] != '\n') {
+                fail("Bulk string is not terminated by CRLF.");
+                return 2;
+        }
+
+        if (reporting_bulk_) {
+                // Empty string, there has been no chunk to report yet.
+                handler_.on_string_chunk(result_type(type_), begin, 0, true);
+                reporting_bulk_ = false;
+        }
+
+        destination_ = nullptr;
+        finish_element();
+
+        return 2;
+}
+
+
+void RespParser::finish_element()
+{
+        while (!stack_.empty() && !--stack_.back().remaining) {
+                const Frame frame{stack_.back()};
+                stack_.pop_back();
+
+                if (frame.attribute) {
+                        // Attributes only annotate the reply following them.
+                        discarding_--;
+                        state_ = State::NeedType;
+                        return;
+                }
+
+                if (!discarding_) {
+                        handler_.on_aggregate_end();
+                }
+        }
+
+        state_ = stack_.empty() ? State::Finished : State::NeedType;
+}
+
+
+void RespParser::fail(const char* message)
+{
+        handler_.on_failure(message);
+
+        stack_.clear();
+        discarding_ = 0;
+        destination_ = nullptr;
+        reporting_bulk_ = false;
+        state_ = State::Finished;
 }
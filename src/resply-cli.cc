@@ -7,6 +7,7 @@
 //
 
 #include <iostream>
+#include <sstream>
 #include <string>
 #include <vector>
 #include <cctype>
@@ -31,7 +32,7 @@ Options parse_commandline(int argc, char** argv)
 
         auto cli = (
                 clipp::option("-h", "--host") & clipp::value("host", options.host)
-                        .doc("Set the host to connect to [default: localhost:6379]"),
+                        .doc("Set the host to connect to, or unix://<path> [default: localhost:6379]"),
                 clipp::option("--help").set(show_help).doc("Show help and exit."),
                 clipp::option("--version").set(show_version).doc("Show version and exit.")
         );
@@ -62,7 +63,8 @@ int main(int argc, char* argv[])
         client.connect();
 
         while (std::cin) {
-                std::cout << client.host() << ':' << client.port() << "> ";
+                // A unix domain socket has no port.
+                std::cout << client.host() << (client.port().empty() ? "" : ':' + client.port()) << "> ";
 
                 std::string line;
                 std::getline(std::cin, line);
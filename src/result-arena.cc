@@ -0,0 +1,106 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <cstdint>
+
+#include "resply.h"
+
+
+namespace resply {
+
+ResultArena::ResultArena(size_t chunk_size)
+        : position_{}, end_{}, chunk_size_{chunk_size}
+{
+}
+
+
+void* ResultArena::allocate(size_t size, size_t alignment)
+{
+        auto align = [alignment](char* pointer) {
+                auto address{reinterpret_cast<std::uintptr_t>(pointer)};
+                return pointer + (-address & (alignment - 1));
+        };
+
+        if (position_ && static_cast<size_t>(end_ - align(position_)) >= size) {
+                char* memory{align(position_)};
+                position_ = memory + size;
+
+                return memory;
+        }
+
+        if (size + alignment > chunk_size_ / 4) {
+                // Would waste too much of a chunk, give it a chunk of its own.
+                large_chunks_.emplace_back(new char[size + alignment]);
+                return align(large_chunks_.back().get());
+        }
+
+        chunks_.emplace_back(new char[chunk_size_]);
+        position_ = chunks_.back().get();
+        end_ = position_ + chunk_size_;
+
+        return allocate(size, alignment);
+}
+
+
+void ResultArena::reset()
+{
+        large_chunks_.clear();
+
+        // Keep one chunk around, arenas are commonly reused.
+        if (chunks_.size() > 1) {
+                chunks_.erase(chunks_.begin() + 1, chunks_.end());
+        }
+
+        position_ = chunks_.empty() ? nullptr : chunks_.front().get();
+        end_ = chunks_.empty() ? nullptr : position_ + chunk_size_;
+}
+
+
+Result ResultView::to_owned() const
+{
+        Result result;
+        result.reset(type);
+
+        switch (type) {
+        case Result::Type::String:
+        case Result::Type::ProtocolError:
+        case Result::Type::IOError:
+        case Result::Type::Timeout:
+        case Result::Type::BigNumber:
+                result.string.value_ = std::string{string};
+                break;
+
+        case Result::Type::Integer:
+        case Result::Type::Boolean:
+                result.integer.value_ = integer;
+                break;
+
+        case Result::Type::Double:
+                result.floating.value_ = floating;
+                break;
+
+        case Result::Type::Array:
+        case Result::Type::Map:
+        case Result::Type::Set:
+        case Result::Type::Push:
+                result.array.value_.reserve(array.size());
+
+                for (const ResultView& element: array) {
+                        result.array.value_.push_back(element.to_owned());
+                }
+
+                break;
+
+        case Result::Type::Nil:
+                break;
+        }
+
+        return result;
+}
+
+}
@@ -0,0 +1,347 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <cstring>
+#include <functional>
+#include <memory>
+
+#include "result-builder.h"
+
+
+using resply::Result;
+using resply::ResultView;
+
+
+void ResultBuilder::reset(Result& destination)
+{
+        result_ = &destination;
+        *result_ = Result{};
+        stack_.clear();
+}
+
+
+void ResultBuilder::io_error(const std::string& message, Result::Type type)
+{
+        stack_.clear();
+        *result_ = Result{type, message};
+}
+
+
+Result& ResultBuilder::next()
+{
+        if (stack_.empty()) {
+                return *result_;
+        }
+
+        std::vector<Result>& elements{stack_.back()->array.value_};
+        elements.emplace_back();
+
+        return elements.back();
+}
+
+
+void ResultBuilder::on_nil()
+{
+        next().reset(Result::Type::Nil);
+}
+
+
+void ResultBuilder::on_integer(Result::Type type, long long value)
+{
+        Result& result{next()};
+
+        result.reset(type);
+        result.integer.value_ = value;
+}
+
+
+void ResultBuilder::on_double(double value)
+{
+        Result& result{next()};
+
+        result.reset(Result::Type::Double);
+        result.floating.value_ = value;
+}
+
+
+char* ResultBuilder::on_string(Result::Type type, std::size_t length)
+{
+        Result& result{next()};
+
+        result.reset(type);
+        result.string.value_.resize(length);
+
+        return &result.string.value_[0];
+}
+
+
+void ResultBuilder::on_aggregate(Result::Type type, std::size_t count)
+{
+        Result& result{next()};
+
+        result.reset(type);
+        result.array.value_.reserve(std::min(count, MAX_RESERVED_ELEMENTS));
+
+        stack_.push_back(&result);
+}
+
+
+void ResultBuilder::on_aggregate_end()
+{
+        stack_.pop_back();
+}
+
+
+void ResultBuilder::on_failure(const char* message)
+{
+        stack_.clear();
+        *result_ = Result{Result::Type::ProtocolError, message};
+}
+
+
+void ViewBuilder::reset(ResultView& destination)
+{
+        result_ = &destination;
+        *result_ = ResultView{};
+        stack_.clear();
+}
+
+
+void ViewBuilder::io_error(const std::string& message, Result::Type type)
+{
+        stack_.clear();
+        set_error(type, message.data(), message.length());
+}
+
+
+ResultView& ViewBuilder::next()
+{
+        if (stack_.empty()) {
+                return *result_;
+        }
+
+        Frame& frame{stack_.back()};
+
+        if (frame.filled == frame.capacity) {
+                const std::size_t capacity{std::min(frame.count, std::max<std::size_t>(frame.capacity * 2, 1))};
+                ResultView* elements{static_cast<ResultView*>(
+                        arena_.allocate(capacity * sizeof(ResultView), alignof(ResultView))
+                )};
+
+                std::uninitialized_copy_n(frame.elements, frame.filled, elements);
+                std::uninitialized_default_construct_n(elements + frame.filled, capacity - frame.filled);
+                on_elements_moved(frame.elements, frame.filled, elements);
+
+                frame.elements = elements;
+                frame.capacity = capacity;
+        }
+
+        return frame.elements[frame.filled++];
+}
+
+
+void ViewBuilder::on_nil()
+{
+        next().type = Result::Type::Nil;
+}
+
+
+void ViewBuilder::on_integer(Result::Type type, long long value)
+{
+        ResultView& result{next()};
+
+        result.type = type;
+        result.integer = value;
+}
+
+
+void ViewBuilder::on_double(double value)
+{
+        ResultView& result{next()};
+
+        result.type = Result::Type::Double;
+        result.floating = value;
+}
+
+
+char* ViewBuilder::on_string(Result::Type type, std::size_t length)
+{
+        ResultView& result{next()};
+        char* data{static_cast<char*>(arena_.allocate(length, 1))};
+
+        result.type = type;
+        result.string = std::string_view{data, length};
+
+        return data;
+}
+
+
+void ViewBuilder::on_aggregate(Result::Type type, std::size_t count)
+{
+        ResultView& result{next()};
+        const std::size_t capacity{std::min(count, MAX_RESERVED_ELEMENTS)};
+        ResultView* elements{static_cast<ResultView*>(
+                arena_.allocate(capacity * sizeof(ResultView), alignof(ResultView))
+        )};
+
+        std::uninitialized_default_construct_n(elements, capacity);
+
+        result.type = type;
+        result.array = ResultView::Array{elements, 0};
+
+        stack_.push_back({&result, elements, 0, count, capacity});
+}
+
+
+void ViewBuilder::on_aggregate_end()
+{
+        const Frame& frame{stack_.back()};
+        frame.aggregate->array = ResultView::Array{frame.elements, frame.filled};
+
+        stack_.pop_back();
+}
+
+
+void ViewBuilder::on_failure(const char* message)
+{
+        stack_.clear();
+        set_error(Result::Type::ProtocolError, message, std::strlen(message));
+}
+
+
+void ViewBuilder::set_error(Result::Type type, const char* message, std::size_t length)
+{
+        char* data{static_cast<char*>(arena_.allocate(length, 1))};
+        std::memcpy(data, message, length);
+
+        *result_ = ResultView{};
+        result_->type = type;
+        result_->string = std::string_view{data, length};
+}
+
+
+void InPlaceViewBuilder::reset()
+{
+        ViewBuilder::reset();
+        unresolved_.clear();
+}
+
+
+void InPlaceViewBuilder::io_error(const std::string& message, Result::Type type)
+{
+        unresolved_.clear();
+        ViewBuilder::io_error(message, type);
+}
+
+
+void InPlaceViewBuilder::resolve(const char* data)
+{
+        for (const Unresolved& string: unresolved_) {
+                string.view->string = std::string_view{data + string.offset, string.length};
+        }
+
+        unresolved_.clear();
+}
+
+
+void InPlaceViewBuilder::on_string_at(Result::Type type, std::size_t offset, std::size_t length)
+{
+        ResultView& result{next()};
+
+        result.type = type;
+        unresolved_.push_back({&result, offset, length});
+}
+
+
+void InPlaceViewBuilder::on_elements_moved(const ResultView* from, std::size_t count, ResultView* to)
+{
+        const std::less<const ResultView*> less;
+
+        for (Unresolved& string: unresolved_) {
+                if (!less(string.view, from) && less(string.view, from + count)) {
+                        string.view = to + (string.view - from);
+                }
+        }
+}
+
+
+void InPlaceViewBuilder::on_failure(const char* message)
+{
+        unresolved_.clear();
+        ViewBuilder::on_failure(message);
+}
+
+
+void StreamAdapter::reset()
+{
+        depth_ = 0;
+        push_ = false;
+}
+
+
+void StreamAdapter::io_error(const std::string& message, Result::Type type)
+{
+        reset();
+        handler_.string_chunk(type, message, true);
+}
+
+
+void StreamAdapter::on_nil()
+{
+        handler_.nil();
+}
+
+
+void StreamAdapter::on_integer(Result::Type type, long long value)
+{
+        handler_.integer(type, value);
+}
+
+
+void StreamAdapter::on_double(double value)
+{
+        handler_.floating(value);
+}
+
+
+char* StreamAdapter::on_string(Result::Type, std::size_t)
+{
+        // Not used, strings are always reported in chunks.
+        return nullptr;
+}
+
+
+void StreamAdapter::on_string_chunk(Result::Type type, const char* data, std::size_t length, bool last)
+{
+        handler_.string_chunk(type, std::string_view{data, length}, last);
+}
+
+
+void StreamAdapter::on_aggregate(Result::Type type, std::size_t count)
+{
+        if (!depth_++) {
+                push_ = type == Result::Type::Push;
+        }
+
+        handler_.begin_array(type, count);
+}
+
+
+void StreamAdapter::on_aggregate_end()
+{
+        depth_--;
+        handler_.end_array();
+}
+
+
+void StreamAdapter::on_failure(const char* message)
+{
+        reset();
+        handler_.string_chunk(Result::Type::ProtocolError, message, true);
+}
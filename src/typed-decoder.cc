@@ -0,0 +1,169 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <string>
+
+#include "resply.h"
+
+
+namespace {
+
+std::string describe_aggregate(resply::Result::Type type, size_t count)
+{
+        switch (type) {
+        case resply::Result::Type::Map:
+                return "a map of " + std::to_string(count / 2) + " entries";
+
+        case resply::Result::Type::Set:
+                return "a set of " + std::to_string(count) + " elements";
+
+        case resply::Result::Type::Push:
+                return "a push message";
+
+        default:
+                return "an array of " + std::to_string(count) + " elements";
+        }
+}
+
+}
+
+
+namespace resply {
+
+void TypedStreamDecoder::begin_array(Result::Type type, size_t count)
+{
+        if (status_ != DecodeStatus::Ok) {
+                return;
+        }
+
+        TypedSinkBase& sink{next_sink()};
+        TypedSinkBase* aggregate{sink.begin_array(type, count)};
+
+        if (!aggregate) {
+                mismatch(sink, describe_aggregate(type, count));
+                return;
+        }
+
+        stack_.push_back(aggregate);
+}
+
+
+void TypedStreamDecoder::end_array()
+{
+        if (status_ != DecodeStatus::Ok) {
+                return;
+        }
+
+        stack_.pop_back();
+        element_done();
+}
+
+
+void TypedStreamDecoder::string_chunk(Result::Type type, std::string_view chunk, bool last)
+{
+        if (type == Result::Type::ProtocolError || type == Result::Type::IOError || type == Result::Type::Timeout) {
+                // Only the first error is kept, e.g. if multiple commands of a pipeline fail.
+                if (status_ == DecodeStatus::Ok) {
+                        status_ = type == Result::Type::ProtocolError ? DecodeStatus::ProtocolError :
+                                  type == Result::Type::IOError ? DecodeStatus::IOError : DecodeStatus::Timeout;
+                        error_string_ = true;
+                }
+
+                if (error_string_) {
+                        error_.append(chunk);
+                        error_string_ = !last;
+                }
+
+                return;
+        }
+
+        if (status_ != DecodeStatus::Ok) {
+                return;
+        }
+
+        const bool first{!string_sink_};
+        TypedSinkBase& sink{first ? next_sink() : *string_sink_};
+        string_sink_ = last ? nullptr : &sink;
+
+        if (!sink.string_chunk(type, chunk, first, last)) {
+                mismatch(sink, type == Result::Type::BigNumber ? "a big number" : "a string");
+        } else if (last) {
+                element_done();
+        }
+}
+
+
+void TypedStreamDecoder::integer(Result::Type type, long long value)
+{
+        if (status_ != DecodeStatus::Ok) {
+                return;
+        }
+
+        TypedSinkBase& sink{next_sink()};
+
+        if (!sink.integer(type, value)) {
+                mismatch(sink, type == Result::Type::Boolean ? "a boolean" : "the integer " + std::to_string(value));
+        } else {
+                element_done();
+        }
+}
+
+
+void TypedStreamDecoder::floating(double value)
+{
+        if (status_ != DecodeStatus::Ok) {
+                return;
+        }
+
+        TypedSinkBase& sink{next_sink()};
+
+        if (!sink.floating(value)) {
+                mismatch(sink, "a double");
+        } else {
+                element_done();
+        }
+}
+
+
+void TypedStreamDecoder::nil()
+{
+        if (status_ != DecodeStatus::Ok) {
+                return;
+        }
+
+        TypedSinkBase& sink{next_sink()};
+
+        if (!sink.nil()) {
+                mismatch(sink, "nil");
+        } else {
+                element_done();
+        }
+}
+
+
+TypedSinkBase& TypedStreamDecoder::next_sink()
+{
+        return stack_.empty() ? root_ : stack_.back()->element();
+}
+
+
+void TypedStreamDecoder::element_done()
+{
+        if (!stack_.empty()) {
+                stack_.back()->element_done();
+        }
+}
+
+
+void TypedStreamDecoder::mismatch(const TypedSinkBase& sink, const std::string& what)
+{
+        status_ = DecodeStatus::TypeMismatch;
+        error_ = "Cannot decode " + what + " as " + sink.name() + ".";
+}
+
+}
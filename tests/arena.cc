@@ -0,0 +1,37 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        client.command("del", "list");
+
+        for (int i{}; i < 1000; i++) {
+                client.command("rpush", "list", i);
+        }
+
+        resply::ResultArena arena;
+        auto range{client.in(arena).command("lrange", "list", 0, -1)};
+
+        if (range.type != resply::Result::Type::Array || range.array.size() != 1000 ||
+            range.array[999].string != "999") {
+                return 0;
+        }
+
+        auto results{client.pipelined().command("llen", "list").command("lindex", "list", 5).send(arena)};
+        auto owned{results[1].to_owned()};
+
+        arena.reset();
+
+        return results.size() == 2 && results[0].integer == 1000 && owned.string == "5";
+}
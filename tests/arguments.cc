@@ -0,0 +1,51 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <array>
+#include <cstddef>
+#include <string>
+#include <string_view>
+#include <vector>
+#include "resply.h"
+
+
+struct Point {
+        int x, y;
+};
+
+template <>
+struct resply::CommandArgument<Point> {
+        static std::string convert(const Point& point)
+        {
+                return std::to_string(point.x) + ':' + std::to_string(point.y);
+        }
+};
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        client.command("del", "zset", "float", "bytes", "point");
+
+        const std::string_view name{"member-and-more", 6};
+        const std::vector<std::byte> bytes{std::byte{0}, std::byte{'\r'}, std::byte{255}};
+        const std::array<char, 3> more{'a', 'b', 'c'};
+
+        client.command("zadd", "zset", 0.1, name);
+        client.command("set", "float", 10.5);
+        client.command("set", "bytes", bytes);
+        client.command("append", "bytes", more);
+        client.command("set", "point", Point{3, -4});
+
+        return client.command("zscore", "zset", "member").string == "0.10000000000000001" &&
+               client.command("incrbyfloat", "float", 0.25).string == "10.75" &&
+               client.command("get", "bytes").string == std::string("\0\r\xff" "abc", 6) &&
+               client.command("get", "point").string == "3:-4";
+}
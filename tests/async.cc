@@ -0,0 +1,91 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <atomic>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <asio.hpp>
+#include "resply.h"
+
+
+int main()
+{
+        {
+                // A client running on its own io_context.
+                resply::Client client;
+                client.connect();
+                client.command("set", "async", "value");
+
+                auto future{client.command_async("get", "async")};
+                client.run();
+
+                if (future.get().string() != "value") {
+                        return 0;
+                }
+        }
+
+        {
+                // The usual order, the shared io_context is only run once connected.
+                asio::io_context io_context;
+                resply::Client client{io_context, "localhost"};
+                client.connect();
+                client.command("set", "async", "shared");
+
+                auto future{client.command_async("get", "async")};
+                io_context.run();
+
+                if (!client.is_connected() || future.get().string() != "shared") {
+                        return 0;
+                }
+        }
+
+        // Many clients sharing a pool of two threads.
+        asio::io_context io_context;
+        auto work{asio::make_work_guard(io_context)};
+        std::vector<std::thread> threads;
+        for (int i{}; i < 2; i++) {
+                threads.emplace_back([&io_context]() { io_context.run(); });
+        }
+
+        std::vector<std::unique_ptr<resply::Client>> clients;
+        for (int i{}; i < 8; i++) {
+                clients.push_back(std::make_unique<resply::Client>(io_context, "localhost"));
+                clients.back()->connect();
+                clients.back()->command("del", "async-" + std::to_string(i));
+        }
+
+        std::vector<std::future<resply::Result>> futures;
+        std::atomic<int> callbacks{};
+
+        for (int i{}; i < 1000; i++) {
+                for (size_t j{}; j < clients.size(); j++) {
+                        futures.push_back(clients[j]->command_async("incr", "async-" + std::to_string(j)));
+                }
+
+                clients[i % clients.size()]->command_async([&callbacks](const resply::Result& reply) {
+                        if (reply.type() == resply::Result::Type::String && reply.string() == "PONG") {
+                                callbacks++;
+                        }
+                }, "ping");
+        }
+
+        bool ok{true};
+        for (size_t i{}; i < futures.size(); i++) {
+                ok = ok && futures[i].get().integer() == static_cast<long long>(i / clients.size() + 1);
+        }
+
+        work.reset();
+        for (std::thread& thread: threads) {
+                thread.join();
+        }
+
+        return ok && callbacks == 1000;
+}
@@ -0,0 +1,84 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <chrono>
+#include <future>
+#include <memory>
+#include <string>
+#include <thread>
+#include <vector>
+#include <asio.hpp>
+#include "resply.h"
+#include "resply-asio.h"
+
+
+namespace {
+
+#if defined(ASIO_HAS_CO_AWAIT)
+asio::awaitable<bool> run_coroutine(resply::Client& client)
+{
+        co_await resply::async_command(client, asio::use_awaitable, "set", "awaitable", "value");
+        resply::Result value{co_await resply::async_command(client, asio::use_awaitable, "get", "awaitable")};
+
+        auto pipeline{client.pipelined()};
+        pipeline.command("incr", "awaitable-counter").command("incr", "awaitable-counter");
+        std::vector<resply::Result> replies{co_await resply::async_send(pipeline, asio::use_awaitable)};
+
+        co_return value.string() == "value" && replies.size() == 2 && replies[1].integer() == replies[0].integer() + 1;
+}
+#endif
+
+}
+
+
+int main()
+{
+        asio::io_context io_context;
+        auto work{asio::make_work_guard(io_context)};
+        std::thread thread{[&io_context]() { io_context.run(); }};
+
+        resply::Client client{io_context, "localhost"};
+        client.connect();
+        client.command("del", "awaitable-list");
+
+        // The reply of the BLPOP arrives long after its deadline, and must not be
+        // mistaken for the reply of the following command.
+        resply::AsyncOptions options;
+        options.deadline = std::chrono::milliseconds{50};
+
+        auto expired{resply::async_command(client, options, asio::use_future, "blpop", "awaitable-list", 1)};
+        auto ping{resply::async_command(client, asio::use_future, "ping")};
+
+        bool ok{expired.get().type() == resply::Result::Type::Timeout && ping.get().string() == "PONG"};
+
+        options.deadline = {};
+        options.cancellation = std::make_shared<resply::CancellationSignal>();
+
+        auto cancelled{resply::async_command(client, options, asio::use_future, "blpop", "awaitable-list", 1)};
+        auto echo{resply::async_command(client, asio::use_future, "echo", "after")};
+        options.cancellation->cancel();
+
+        ok = ok && cancelled.get().type() == resply::Result::Type::IOError && echo.get().string() == "after";
+
+        auto pipeline{client.pipelined()};
+        for (int i{}; i < 100; i++) {
+                pipeline.command("echo", i);
+        }
+
+        auto replies{resply::async_send(pipeline, asio::use_future).get()};
+        ok = ok && replies.size() == 100 && replies[99].string() == "99";
+
+#if defined(ASIO_HAS_CO_AWAIT)
+        ok = ok && asio::co_spawn(io_context, run_coroutine(client), asio::use_future).get();
+#endif
+
+        work.reset();
+        thread.join();
+
+        return ok;
+}
@@ -0,0 +1,78 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <clocale>
+#include <limits>
+#include <string>
+#include <string_view>
+#include "resply.h"
+#include "resp-parser.h"
+#include "result-builder.h"
+
+
+namespace {
+
+/*! \brief Formats \p value like a command argument, which the proxy also uses for RESP3 doubles. */
+std::string format(double value)
+{
+        const auto formatted{resply::CommandArgument<double>::convert(value)};
+
+        return std::string{std::string_view{formatted}};
+}
+
+bool round_trips(double value)
+{
+        double parsed;
+        return resply::detail::parse_floating(format(value), parsed) && parsed == value;
+}
+
+/*! \brief Parses the RESP3 double \p reply. */
+resply::Result parse(const std::string& reply)
+{
+        ResultBuilder builder;
+        RespParser parser{builder};
+        parser.parse(reply.data(), reply.size());
+
+        return builder.result();
+}
+
+}
+
+
+int main()
+{
+        // Neither parsing nor formatting may depend on the decimal separator of the locale.
+        for (const char* locale: {"de_DE.UTF-8", "de_DE.utf8", "fr_FR.UTF-8", "de_DE"}) {
+                if (std::setlocale(LC_NUMERIC, locale)) {
+                        break;
+                }
+        }
+
+        const resply::Result small{parse(",1.5e-9\r\n")}, large{parse(",+1.5e300\r\n")};
+
+        bool ok{small.type == resply::Result::Type::Double && small.floating == 1.5e-9 &&
+                large.type == resply::Result::Type::Double && large.floating == 1.5e300 &&
+                parse(",-inf\r\n").floating == -std::numeric_limits<double>::infinity() &&
+                parse(",1,5\r\n").type == resply::Result::Type::ProtocolError &&
+                parse(", 1.5\r\n").type == resply::Result::Type::ProtocolError};
+
+        ok = ok && format(1e-9) == "1e-09" && format(0.1) == "0.1" && format(1.5e300) == "1.5e+300" &&
+             format(-2.0) == "-2" && format(std::numeric_limits<double>::infinity()) == "inf" &&
+             round_trips(1e-9) && round_trips(1.5e300) && round_trips(0.1 + 0.2) &&
+             round_trips(std::numeric_limits<double>::max()) &&
+             round_trips(std::numeric_limits<double>::denorm_min());
+
+        // Strings holding a number are decoded the same way.
+        resply::Client client;
+        client.connect();
+        client.command("set", "doubles", 0.1 + 0.2);
+
+        auto typed{client.command_as<double>("get", "doubles")};
+
+        return ok && typed && typed.value == 0.1 + 0.2;
+}
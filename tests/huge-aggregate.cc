@@ -0,0 +1,76 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <string>
+#include "resply.h"
+#include "resp-parser.h"
+#include "result-builder.h"
+
+
+namespace {
+
+/*! \brief Parses the complete reply in \p data in one go. */
+bool parse(RespParser& parser, const std::string& data)
+{
+        return parser.parse(data.data(), data.size()) == data.size() && parser.finished();
+}
+
+}
+
+
+int main()
+{
+        resply::ResultArena arena;
+
+        // Only the header of an aggregate far too large to allocate up front,
+        // the parser then waits for its elements, until it fails on garbage.
+        ViewBuilder huge{arena};
+        RespParser huge_parser{huge};
+        const std::string header{"*4000000000\r\n:1\r\n:2\r\n"};
+
+        bool ok{huge_parser.parse(header.data(), header.size()) == header.size() && !huge_parser.finished()};
+
+        huge_parser.parse("?\r\n", 3);
+        ok = ok && huge_parser.finished() && huge.result().type == resply::Result::Type::ProtocolError;
+
+        // Larger than reserved up front, so the elements are moved while the strings are still unresolved.
+        const size_t COUNT{200000};
+        std::string strings{"*" + std::to_string(COUNT) + "\r\n"};
+        std::string nested{"*" + std::to_string(COUNT) + "\r\n"};
+
+        for (size_t i{}; i < COUNT; i++) {
+                const std::string value{std::to_string(i)};
+
+                strings += "$" + std::to_string(value.length()) + "\r\n" + value + "\r\n";
+                nested += "*2\r\n:" + value + "\r\n+" + value + "\r\n";
+        }
+
+        InPlaceViewBuilder in_place{arena};
+        RespParser in_place_parser{in_place};
+        ok = ok && parse(in_place_parser, strings);
+        in_place.resolve(strings.data());
+
+        ViewBuilder copied{arena};
+        RespParser copied_parser{copied};
+        ok = ok && parse(copied_parser, nested);
+
+        const resply::ResultView& in_place_result{in_place.result()};
+        const resply::ResultView& copied_result{copied.result()};
+
+        ok = ok && in_place_result.array.size() == COUNT && copied_result.array.size() == COUNT;
+
+        for (size_t i{}; ok && i < COUNT; i++) {
+                const std::string value{std::to_string(i)};
+                const resply::ResultView& pair{copied_result.array[i]};
+
+                ok = in_place_result.array[i].string == value && pair.array.size() == 2 &&
+                     pair.array[0].integer == static_cast<long long>(i) && pair.array[1].string == value;
+        }
+
+        return ok;
+}
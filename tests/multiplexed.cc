@@ -0,0 +1,67 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <atomic>
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <vector>
+#include "resply.h"
+
+
+int main()
+{
+        resply::MultiplexedClient client;
+        client.connect();
+        client.command("del", "multiplexed");
+
+        const int THREADS{8}, COMMANDS{2000};
+        std::atomic<bool> ok{true};
+        std::vector<std::thread> threads;
+
+        for (int i{}; i < THREADS; i++) {
+                threads.emplace_back([&client, &ok, i]() {
+                        const std::string key{"multiplexed-" + std::to_string(i)};
+                        client.command("del", key);
+
+                        for (int j{1}; j <= COMMANDS; j++) {
+                                client.command("incr", "multiplexed");
+
+                                // Each thread must get the replies to its own commands.
+                                if (client.command("incr", key).integer != j) {
+                                        ok = false;
+                                }
+                        }
+                });
+        }
+
+        for (std::thread& thread: threads) {
+                thread.join();
+        }
+
+        // A blocking command in a callback would wait for the I/O thread it runs on.
+        std::promise<resply::Result> nested;
+        client.command_async([&](const resply::Result&) { nested.set_value(client.command("ping")); }, "ping");
+        ok = ok && nested.get_future().get().type == resply::Result::Type::IOError;
+
+        // Destroying the client does not wait for a reply which never arrives.
+        std::future<resply::Result> blocked;
+        const auto start{std::chrono::steady_clock::now()};
+        {
+                resply::MultiplexedClient stalled;
+                stalled.connect();
+                blocked = stalled.command_async("blpop", "multiplexed-never", 0);
+                std::this_thread::sleep_for(std::chrono::milliseconds{100});
+        }
+
+        ok = ok && std::chrono::steady_clock::now() - start < std::chrono::seconds{1} &&
+             blocked.get().type == resply::Result::Type::IOError;
+
+        return ok && client.command("get", "multiplexed").string == std::to_string(THREADS * COMMANDS);
+}
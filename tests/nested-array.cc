@@ -0,0 +1,31 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        auto result{client.command("eval", "return {1, {'a', {2}}, 3}", 0)};
+
+        if (result.type != resply::Result::Type::Array || result.array.size() != 3) {
+                return 0;
+        }
+
+        const auto& inner{result.array[1]};
+
+        return result.array[0].type == resply::Result::Type::Integer && result.array[0].integer == 1 &&
+               inner.type == resply::Result::Type::Array && inner.array.size() == 2 &&
+               inner.array[0].type == resply::Result::Type::String && inner.array[0].string == "a" &&
+               inner.array[1].type == resply::Result::Type::Array && inner.array[1].array.size() == 1 &&
+               inner.array[1].array[0].integer == 2 &&
+               result.array[2].type == resply::Result::Type::Integer && result.array[2].integer == 3;
+}
@@ -0,0 +1,124 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <atomic>
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+#include "resply.h"
+
+
+namespace {
+
+bool ping(resply::Client& client)
+{
+        return client.command("ping").string() == "PONG";
+}
+
+}
+
+
+int main()
+{
+        resply::ClientPoolOptions options;
+        options.min_size = 1;
+        options.max_size = 2;
+        options.wait_timeout = std::chrono::milliseconds{50};
+        options.health_check_interval = std::chrono::milliseconds{50};
+        options.idle_timeout = std::chrono::milliseconds{100};
+
+        bool ok{true};
+
+        {
+                resply::ClientPool pool{"localhost", options};
+
+                auto first{pool.acquire()}, second{pool.acquire()};
+                ok = ok && first && second && ping(first) && ping(*second);
+
+                // Exhausted, until one is released.
+                ok = ok && !pool.acquire();
+                first.reset();
+                ok = ok && pool.acquire() && pool.size() == 2;
+
+                // The connection beyond the minimum is closed once idle for long enough.
+                second.reset();
+                std::this_thread::sleep_for(std::chrono::milliseconds{300});
+                ok = ok && pool.size() == 1;
+
+                // Dead connections are replaced by the health checks.
+                resply::Client admin;
+                admin.connect();
+                admin.command("client", "kill", "skipme", "yes", "type", "normal");
+                std::this_thread::sleep_for(std::chrono::milliseconds{200});
+                ok = ok && ping(pool.acquire());
+        }
+
+        {
+                // A stalled connection fails its health check in time, instead of holding up
+                // the background thread, which is joined on destruction, until the server resumes.
+                resply::Client admin;
+                admin.connect();
+
+                auto start{std::chrono::steady_clock::now()};
+                {
+                        resply::ClientPool pool{"localhost", options};
+                        admin.command("client", "pause", 500);
+                        std::this_thread::sleep_for(std::chrono::milliseconds{100});
+                }
+
+                ok = ok && std::chrono::steady_clock::now() - start < std::chrono::milliseconds{400};
+        }
+
+        {
+                // Parked clients are idle since they were released, not since the pool noticed them.
+                resply::ClientPoolOptions parking;
+                parking.min_size = 0;
+                parking.max_size = 2;
+                parking.thread_affinity = true;
+                parking.health_check_interval = std::chrono::milliseconds{200};
+                parking.idle_timeout = std::chrono::milliseconds{500};
+
+                const auto start{std::chrono::steady_clock::now()};
+                resply::ClientPool pool{"localhost", parking};
+
+                {
+                        // One is parked for this thread, the other one is idle.
+                        auto first{pool.acquire()}, second{pool.acquire()};
+                }
+
+                // Both are closed on the check after 600ms, instead of one check later.
+                std::this_thread::sleep_until(start + std::chrono::milliseconds{700});
+                ok = ok && pool.size() == 0;
+        }
+
+        options.max_size = 4;
+        options.thread_affinity = true;
+
+        resply::ClientPool pool{"localhost", options};
+        pool.acquire()->command("del", "pool");
+
+        std::vector<std::thread> threads;
+        for (int i{}; i < 8; i++) {
+                threads.emplace_back([&pool]() {
+                        for (int j{}; j < 500;) {
+                                if (auto client{pool.acquire()}) {
+                                        client->command("incr", "pool");
+                                        j++;
+                                }
+                        }
+                });
+        }
+
+        for (std::thread& thread: threads) {
+                thread.join();
+        }
+
+        auto client{pool.acquire()};
+        return ok && pool.size() <= 4 && client->command("get", "pool").string() == "4000";
+}
@@ -0,0 +1,37 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <string>
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        client.command("del", "counters");
+
+        const resply::PreparedCommand hincrby{"hincrby", "counters", resply::placeholder, 2};
+        const resply::PreparedCommand<0> ping{"ping"};
+
+        for (int i{}; i < 10; i++) {
+                client.command(hincrby, "direct");
+        }
+
+        auto pipeline{client.pipelined()};
+        for (int i{}; i < 10; i++) {
+                pipeline.command(hincrby, std::string{"pipelined"});
+        }
+
+        auto results{pipeline.send()};
+
+        return results.size() == 10 && results.back().integer == 20 &&
+               client.command("hget", "counters", "direct").string == "20" &&
+               client.command(ping).string == "PONG";
+}
@@ -0,0 +1,62 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <algorithm>
+#include <cstring>
+#include "receive-buffer.h"
+
+
+namespace {
+
+/*! \brief Receives \p count bytes, in reads as large as requested. */
+void receive(ReceiveBuffer& buffer, size_t count)
+{
+        while (count) {
+                const size_t read{std::min(count, buffer.read_size())};
+
+                std::memset(buffer.prepare(), 'x', read);
+                buffer.commit(read);
+                count -= read;
+        }
+}
+
+}
+
+
+int main()
+{
+        ReceiveBuffer buffer;
+
+        // A large reply, referenced in place until it is done with.
+        buffer.pin();
+        receive(buffer, 64 * 1024 * 1024);
+        buffer.consume(buffer.size());
+
+        bool ok{buffer.capacity() >= 64 * 1024 * 1024};
+
+        // Still pinned, so nothing may be released yet.
+        receive(buffer, 10);
+        ok = ok && buffer.capacity() >= 64 * 1024 * 1024 && buffer.size() == 10;
+
+        buffer.consume(buffer.size());
+        buffer.unpin();
+
+        // Drained, the storage shrinks back along with the read size.
+        for (int i{}; i < 16; i++) {
+                receive(buffer, 100);
+                buffer.consume(buffer.size());
+        }
+
+        ok = ok && buffer.capacity() <= 8 * buffer.read_size() && buffer.read_size() < 64 * 1024;
+
+        // Still fine for the next large reply.
+        receive(buffer, 1024 * 1024);
+        ok = ok && buffer.size() == 1024 * 1024;
+
+        return ok;
+}
@@ -0,0 +1,51 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <string>
+#include "resply.h"
+#include "resp-parser.h"
+#include "result-builder.h"
+
+
+namespace {
+
+/*! \brief Parses \p reply, split into pieces of \p chunk bytes. */
+resply::Result parse(const std::string& reply, size_t chunk=std::string::npos)
+{
+        ResultBuilder builder;
+        RespParser parser{builder};
+
+        std::string pending;
+        for (size_t position{}; position < reply.size() && !parser.finished(); position += chunk) {
+                pending += reply.substr(position, chunk);
+                pending.erase(0, parser.parse(pending.data(), pending.size()));
+        }
+
+        return parser.finished() ? builder.result() : resply::Result{resply::Result::Type::IOError, "Incomplete."};
+}
+
+bool is_protocol_error(const resply::Result& result)
+{
+        return result.type == resply::Result::Type::ProtocolError;
+}
+
+}
+
+
+int main()
+{
+        bool ok{parse("$3\r\nabc\r\n").string == "abc" && parse("$3\r\nabc\r\n", 1).string == "abc" &&
+                parse("*2\r\n$0\r\n\r\n:1\r\n", 1).array.size() == 2};
+
+        // The length does not match the payload, or garbage follows it.
+        ok = ok && is_protocol_error(parse("$3\r\nabcd\r\n")) && is_protocol_error(parse("$3\r\nab\r\n:1\r\n")) &&
+             is_protocol_error(parse("$3\r\nabcXY")) && is_protocol_error(parse("$3\r\nabc\n\r", 1)) &&
+             is_protocol_error(parse("*2\r\n$1\r\nab\r\n$1\r\nc\r\n", 2));
+
+        return ok;
+}
@@ -0,0 +1,31 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.protocol_version(3);
+        client.connect();
+
+        if (client.protocol_version() != 3) {
+                return 0;
+        }
+
+        client.command("del", "h");
+        client.command("hset", "h", "a", "1");
+
+        auto map{client.command("hgetall", "h")};
+        auto exists{client.command("sismember", "nonexistent-set", "a")};
+
+        return map.type == resply::Result::Type::Map && map.array.size() == 2 &&
+               map.array[0].string == "a" && map.array[1].string == "1" &&
+               exists.type == resply::Result::Type::Integer && exists.integer == 0;
+}
@@ -0,0 +1,54 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <sstream>
+#include <string>
+#include <vector>
+#include "resply.h"
+
+
+int main()
+{
+        using Type = resply::Result::Type;
+
+        const resply::Result integer{42};
+        const resply::Result string{Type::String, "value"};
+        const resply::Result array{Type::Array, {integer, string}};
+        resply::Result nil;
+
+        // The values read like the plain members they used to be, and through the accessors.
+        bool ok{integer.type == Type::Integer && integer.integer == 42 && integer.integer() + 1 == 43 &&
+                string.type() == Type::String && string.string == "value" && "value" == string.string &&
+                string.string().length() == 5 && string.string.size() == 5 && string.string[0] == 'v' &&
+                array.array.size() == 2 && array.array[1].string == string.string &&
+                array.array().front().integer == 42 && nil.type == Type::Nil};
+
+        long long sum{};
+        for (const resply::Result& element: array.array) {
+                sum += element.type == Type::Integer ? element.integer : 0;
+        }
+
+        switch (array.type) {
+        case Type::Array:
+                break;
+        default:
+                ok = false;
+        }
+
+        std::ostringstream stream;
+        stream << string.string << integer.integer;
+
+        // Changing the type switches the value, which starts out empty.
+        nil.reset(Type::Array);
+        ok = ok && nil.array.empty() && nil.is_aggregate();
+
+        nil = string;
+        ok = ok && nil.string == "value" && !nil.is_aggregate();
+
+        return ok && sum == 42 && stream.str() == "value42" && sizeof(resply::Result) <= sizeof(std::string) + sizeof(long long);
+}
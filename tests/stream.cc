@@ -0,0 +1,49 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <string>
+#include "resply.h"
+
+
+struct Counter : resply::StreamHandler {
+        void begin_array(resply::Result::Type, size_t size) override { announced += size; }
+        void end_array() override { ended++; }
+
+        void string_chunk(resply::Result::Type, std::string_view chunk, bool last) override
+        {
+                bytes += chunk.size();
+                strings += last;
+        }
+
+        size_t announced{}, ended{}, strings{}, bytes{};
+};
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        client.command("del", "list");
+
+        for (int i{}; i < 1000; i++) {
+                client.command("rpush", "list", std::string(100, 'x'));
+        }
+
+        Counter list;
+        client.command_stream(list, "lrange", "list", 0, -1);
+
+        client.command("set", "big", std::string(4 * 1024 * 1024, 'y'));
+
+        Counter big;
+        client.command_stream(big, "get", "big");
+
+        return list.announced == 1000 && list.ended == 1 && list.strings == 1000 && list.bytes == 100000 &&
+               big.strings == 1 && big.bytes == 4 * 1024 * 1024 &&
+               client.command("ping").string == "PONG";
+}
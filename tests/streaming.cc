@@ -0,0 +1,92 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <array>
+#include <string>
+#include <thread>
+#include <asio.hpp>
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        client.command("del", "counter");
+
+        size_t replies{}, max_in_flight{};
+        long long last{};
+
+        {
+                auto pipeline{client.streaming([&](const resply::Result& reply) {
+                        replies++;
+                        last = reply.integer;
+                }, 100, 4096, 500)};
+
+                for (int i{}; i < 20000; i++) {
+                        pipeline.command("incr", "counter");
+                        max_in_flight = std::max(max_in_flight, pipeline.in_flight());
+                }
+        }
+
+        if (replies != 20000 || last != 20000 || max_in_flight > 500 ||
+            client.command("get", "counter").string != "20000") {
+                return 0;
+        }
+
+        // A server which only reads further commands once its replies are written,
+        // like redis does once its output buffer is full. It echoes each command,
+        // which reads back as an array reply. The batch is far larger than the
+        // socket buffers, so it only finishes if replies are read while it is written.
+        const std::string value(100, 'v');
+        const size_t command_size{std::string{"*2\r\n$4\r\necho\r\n$100\r\n"}.size() + value.size() + 2};
+
+        asio::io_context io_context;
+        asio::ip::tcp::acceptor listener{io_context, {asio::ip::make_address("127.0.0.1"), 0}};
+
+        std::thread server{[&]() {
+                asio::ip::tcp::socket socket{io_context};
+                listener.accept(socket);
+
+                std::array<char, 64 * 1024> data;
+                std::string received;
+                asio::error_code read_error, write_error;
+
+                while (!read_error && !write_error) {
+                        received.append(data.data(), socket.read_some(asio::buffer(data), read_error));
+
+                        // Like any server, only replies to complete commands.
+                        const size_t complete{received.size() - received.size() % command_size};
+                        asio::write(socket, asio::buffer(received.data(), complete), write_error);
+                        received.erase(0, complete);
+                }
+        }};
+
+        resply::Client echo{"127.0.0.1:" + std::to_string(listener.local_endpoint().port()), 5000};
+        echo.connect();
+        echo.command_timeout(std::chrono::seconds{5});
+
+        size_t echoed{};
+
+        {
+                auto pipeline{echo.streaming([&](const resply::Result& reply) {
+                        echoed += reply.type == resply::Result::Type::Array &&
+                                  reply.array.size() == 2 && reply.array[1].string == value;
+                }, 1000000, 64 * 1024 * 1024, 1000000)};
+
+                for (int i{}; i < 200000; i++) {
+                        pipeline.command("echo", value);
+                }
+        }
+
+        echo.close();
+        server.join();
+
+        return echoed == 200000;
+}
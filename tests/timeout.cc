@@ -0,0 +1,105 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <vector>
+#include <asio.hpp>
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+        client.command("del", "timeout-list");
+
+        // BLPOP blocks for a second, like a stalled server would.
+        client.command_timeout(std::chrono::milliseconds{100});
+
+        const auto start{std::chrono::steady_clock::now()};
+        auto blocked{client.command("blpop", "timeout-list", 1)};
+        const bool in_time{std::chrono::steady_clock::now() - start < std::chrono::milliseconds{900}};
+
+        bool ok{in_time && blocked.type() == resply::Result::Type::Timeout && !client.is_connected()};
+
+        client.connect();
+        ok = ok && client.command("ping").string() == "PONG";
+
+        auto typed{client.command_as<std::vector<std::string>>("blpop", "timeout-list", 1)};
+        ok = ok && typed.status == resply::DecodeStatus::Timeout;
+
+        // The whole batch has to finish in time, not each command.
+        client.connect();
+        client.command_timeout({});
+
+        auto replies{
+                client.pipelined()
+                        .timeout(std::chrono::milliseconds{100})
+                        .command("ping")
+                        .command("blpop", "timeout-list", 1)
+                        .command("ping")
+                        .send()
+        };
+
+        ok = ok && replies.size() == 3 && replies[0].string() == "PONG" &&
+             replies[1].type() == resply::Result::Type::Timeout && replies[2].type() == resply::Result::Type::Timeout;
+
+        // Asynchronous commands default to the command timeout as their deadline.
+        client.connect();
+        client.command_timeout(std::chrono::milliseconds{100});
+
+        auto expired{client.command_async("blpop", "timeout-list", 1)};
+        client.run();
+        ok = ok && expired.get().type() == resply::Result::Type::Timeout;
+
+        // Nothing listens on this port, so connecting fails either way.
+        resply::Client unreachable{"localhost:1", 100};
+        unreachable.connect();
+
+        // Connecting is bounded even while nothing runs the shared io_context.
+        // The listener never accepts and its backlog is full, so the connect stalls.
+        asio::io_context io_context;
+        asio::ip::tcp::acceptor listener{io_context};
+        listener.open(asio::ip::tcp::v4());
+        listener.bind({asio::ip::make_address("127.0.0.1"), 0});
+        listener.listen(0);
+
+        std::vector<asio::ip::tcp::socket> backlog;
+        backlog.reserve(4);
+        for (int i{}; i < 4; i++) {
+                backlog.emplace_back(io_context);
+                backlog.back().async_connect(listener.local_endpoint(), [](const asio::error_code&) { });
+        }
+
+        resply::Client shared{io_context, "127.0.0.1:" + std::to_string(listener.local_endpoint().port()), 100};
+
+        const auto connecting{std::chrono::steady_clock::now()};
+        shared.connect();
+        const bool connected_in_time{std::chrono::steady_clock::now() - connecting < std::chrono::milliseconds{900}};
+
+        // A synchronous command from a handler on the shared io_context would wait for itself.
+        asio::io_context handlers;
+        resply::Client first{handlers, "localhost"}, second{handlers, "localhost"};
+        first.connect();
+        second.connect();
+        second.command_timeout(std::chrono::milliseconds{1000});
+
+        resply::Result nested;
+        first.command_async([&](const resply::Result&) { nested = second.command("ping"); }, "ping");
+
+        const auto nesting{std::chrono::steady_clock::now()};
+        handlers.run();
+        const bool nested_in_time{std::chrono::steady_clock::now() - nesting < std::chrono::milliseconds{500}};
+
+        ok = ok && nested_in_time && nested.type == resply::Result::Type::IOError && second.is_connected();
+
+        return ok && !unreachable.is_connected() && connected_in_time && !shared.is_connected() &&
+               client.command("ping").string() == "PONG";
+}
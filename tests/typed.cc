@@ -0,0 +1,48 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <map>
+#include <optional>
+#include <string>
+#include <tuple>
+#include <unordered_map>
+#include <vector>
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        client.command("del", "list", "hash", "counter");
+        client.command("rpush", "list", 1, 2, 3);
+        client.command("hset", "hash", "a", 1, "b", 2);
+
+        auto list{client.command_as<std::vector<long long>>("lrange", "list", 0, -1)};
+        auto hash{client.command_as<std::unordered_map<std::string, int>>("hgetall", "hash")};
+        auto missing{client.command_as<std::vector<std::optional<std::string>>>("hmget", "hash", "a", "x")};
+        auto mismatch{client.command_as<std::map<std::string, std::string>>("lrange", "list", 0, -1)};
+        auto error{client.command_as<long long>("incr", "list")};
+
+        auto batch{
+                client.pipelined()
+                        .command("incr", "counter")
+                        .command("set", "key", "value")
+                        .command("get", "key")
+                        .send_as<std::tuple<int, std::string, std::optional<std::string>>>()
+        };
+
+        return list && list.value == std::vector<long long>{1, 2, 3} &&
+               hash && hash.value.size() == 2 && hash.value["a"] == 1 && hash.value["b"] == 2 &&
+               missing && missing.value.size() == 2 && missing.value[0] == "1" && !missing.value[1] &&
+               mismatch.status == resply::DecodeStatus::TypeMismatch &&
+               error.status == resply::DecodeStatus::ProtocolError && error.error.find("WRONGTYPE") == 0 &&
+               batch && batch.value == std::make_tuple(1, std::string{"OK"}, std::optional<std::string>{"value"}) &&
+               client.command("ping").string == "PONG";
+}
@@ -0,0 +1,69 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <chrono>
+#include <future>
+#include <string>
+#include <thread>
+#include <utility>
+#include "resply.h"
+
+using namespace std::literals;
+
+
+// Expects the redis server on localhost:6379 to also listen on /tmp/redis.sock
+// (e.g. started with `--unixsocket /tmp/redis.sock`).
+int main()
+{
+        resply::Client client{"unix:///tmp/redis.sock"};
+        client.connect();
+
+        auto replies{
+                client.pipelined()
+                        .command("set", "unix-socket", "value")
+                        .command("get", "unix-socket")
+                        .send()
+        };
+
+        bool ok{client.is_connected() && client.port().empty() && replies.size() == 2 &&
+                replies[1].string == "value"};
+
+        // Published over TCP, received over the unix domain socket.
+        resply::Client subscriber{"unix:///tmp/redis.sock"}, publisher;
+        subscriber.connect();
+        publisher.connect();
+
+        std::promise<std::pair<std::string, std::string>> result;
+        subscriber.subscribe("unix-socket", [&](const auto& channel, const auto& message) {
+                result.set_value(std::make_pair(channel, message));
+        });
+
+        std::thread{[&]() { subscriber.listen_for_messages(); }}.detach();
+
+        std::this_thread::sleep_for(1s);
+        publisher.command("publish", "unix-socket", "message");
+
+        auto message{result.get_future().get()};
+        ok = ok && message.first == "unix-socket" && message.second == "message";
+
+        resply::Redlock rlock1{"resply-unix-socket-test", {
+                "unix:///tmp/redis.sock", "localhost:6380", "localhost:6381",
+                "localhost:6382", "localhost:6383"
+        }};
+        rlock1.initialize();
+
+        resply::Redlock rlock2{"resply-unix-socket-test", {
+                "unix:///tmp/redis.sock", "localhost:6380", "localhost:6381",
+                "localhost:6382", "localhost:6383"
+        }};
+        rlock2.initialize();
+
+        ok = ok && rlock1.lock(750) && !rlock2.lock(500);
+
+        return ok;
+}
@@ -0,0 +1,42 @@
+//
+// Copyright 2018 Christoph Heiss <me@christoph-heiss.me>
+// Distributed under the Boost Software License, Version 1.0.
+//
+// See accompanying file LICENSE in the project root directory
+// or copy at http://www.boost.org/LICENSE_1_0.txt
+//
+
+#include <string>
+#include "resply.h"
+
+
+int main()
+{
+        resply::Client client;
+        client.connect();
+
+        const std::string value(1000, 'x');
+        client.command("del", "list");
+
+        for (int i{}; i < 1000; i++) {
+                client.command("rpush", "list", value + std::to_string(i));
+        }
+
+        auto range{client.view().command("lrange", "list", 0, -1)};
+
+        if (range.type != resply::Result::Type::Array || range.array.size() != 1000) {
+                return 0;
+        }
+
+        for (size_t i{}; i < range.array.size(); i++) {
+                if (range.array[i].string != value + std::to_string(i)) {
+                        return 0;
+                }
+        }
+
+        client.command("set", "big", std::string(4 * 1024 * 1024, 'y'));
+        auto big{client.view().command("get", "big").to_owned()};
+        auto pong{client.view().command("ping")};
+
+        return big.string == std::string(4 * 1024 * 1024, 'y') && pong.string == "PONG";
+}